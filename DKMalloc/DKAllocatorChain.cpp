@@ -55,6 +55,8 @@ namespace DKFoundation
 
 		void CreateAllocationTable(void);
 		void DestroyAllocationTable(void);
+		void* MetadataAlloc(size_t);
+		void MetadataFree(void*);
 
 		using ScopedSpinLock = DKCriticalSection<DKSpinLock>;
 		struct Chain
@@ -118,11 +120,11 @@ namespace DKFoundation
 			}
 			void* operator new (size_t s)
 			{
-				return DKMemoryHeapAlloc(s);
+				return MetadataAlloc(s);
 			}
 			void operator delete (void* p) noexcept
 			{
-				DKMemoryHeapFree(p);
+				MetadataFree(p);
 			}
 		};
 		Chain* Chain::instance;
@@ -214,10 +216,10 @@ DKAllocatorChain::Maintainer::~Maintainer(void) noexcept(!DKGL_MEMORY_DEBUG)
 
 void* DKAllocatorChain::operator new (size_t s)
 {
-	return DKMemoryHeapAlloc(s);
+	return MetadataAlloc(s);
 }
 
 void DKAllocatorChain::operator delete (void* p) noexcept
 {
-	DKMemoryHeapFree(p);
+	MetadataFree(p);
 }
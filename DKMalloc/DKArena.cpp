@@ -0,0 +1,216 @@
+/*******************************************************************************
+ File: DKArena.cpp
+ Author: Hongtae Kim (tiff2766@gmail.com)
+
+ Copyright (c) 2015,2017 Hongtae Kim. All rights reserved.
+
+ NOTE: This is simplified 'Memory Allocator' part of DKGL.
+ Full version of DKGL: https://github.com/DKGL/DKGL
+
+ License: BSD-3
+*******************************************************************************/
+/*******************************************************************************
+
+ Copyright (c) 2015, Hongtae Kim.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of DKMalloc nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*******************************************************************************/
+
+#include "DKArena.h"
+
+namespace DKFoundation
+{
+	struct DKArena::Chunk
+	{
+		Chunk* next;
+		size_t used;	// used bytes, updated when chunk is not current chunk.
+	};
+	struct DKArena::LargeBlock
+	{
+		LargeBlock* next;
+		void* ptr;
+		size_t size;
+		size_t alignment;
+	};
+}
+
+using namespace DKFoundation;
+
+DKArena::DKArena(void)
+	: chunks(NULL)
+	, freeChunks(NULL)
+	, largeBlocks(NULL)
+	, position(1)	// position > end, even Alloc(0) takes AllocSlow.
+	, end(0)
+{
+}
+
+DKArena::~DKArena(void)
+{
+	Release();
+}
+
+void* DKArena::AllocSlow(size_t s, size_t alignment)
+{
+	const size_t chunkSize = DKMemoryPoolChunkSize();
+	const size_t maxBlockSize = chunkSize - sizeof(Chunk);
+
+	if (alignment >= maxBlockSize || s > maxBlockSize - alignment)
+	{
+		// large block, allocate from memory pool directly.
+		void* ptr = DKMemoryPoolAlignedAlloc(s, alignment);
+		if (ptr == NULL)
+			return NULL;
+		LargeBlock* block = static_cast<LargeBlock*>(Alloc(sizeof(LargeBlock), alignof(LargeBlock)));
+		if (block == NULL)
+		{
+			DKMemoryPoolAlignedFreeSized(ptr, s, alignment);
+			return NULL;
+		}
+		block->ptr = ptr;
+		block->size = s;
+		block->alignment = alignment;
+		block->next = largeBlocks;
+		largeBlocks = block;
+		return block->ptr;
+	}
+
+	// take next chunk.
+	Chunk* chunk = freeChunks;
+	if (chunk)
+	{
+		freeChunks = chunk->next;
+	}
+	else
+	{
+		chunk = static_cast<Chunk*>(DKMemoryPoolChunkAlloc());
+		if (chunk == NULL)
+			return NULL;
+	}
+	if (chunks)
+		chunks->used = position - reinterpret_cast<uintptr_t>(chunks);
+	chunk->next = chunks;
+	chunk->used = 0;
+	chunks = chunk;
+	position = reinterpret_cast<uintptr_t>(chunk) + sizeof(Chunk);
+	end = reinterpret_cast<uintptr_t>(chunk) + chunkSize;
+
+	void* p = Alloc(s, alignment);
+	DKASSERT_MEM_DEBUG(p != NULL);
+	return p;
+}
+
+void DKArena::FreeLargeBlocks(LargeBlock* last)
+{
+	while (largeBlocks != last)
+	{
+		DKASSERT_MEM_DEBUG(largeBlocks != NULL);
+		LargeBlock* block = largeBlocks;
+		largeBlocks = block->next;
+		DKMemoryPoolAlignedFreeSized(block->ptr, block->size, block->alignment);
+	}
+}
+
+DKArena::Mark DKArena::GetMark(void) const
+{
+	Mark mark = { chunks, position, largeBlocks };
+	return mark;
+}
+
+void DKArena::Rewind(const Mark& mark)
+{
+	FreeLargeBlocks(mark.largeBlocks);
+	while (chunks != mark.chunk)
+	{
+		DKASSERT_MEM_DESC_DEBUG(chunks != NULL, "Invalid mark!");
+		Chunk* chunk = chunks;
+		chunks = chunk->next;
+		chunk->next = freeChunks;
+		freeChunks = chunk;
+	}
+	if (chunks)
+	{
+		DKASSERT_MEM_DEBUG(mark.position >= reinterpret_cast<uintptr_t>(chunks) + sizeof(Chunk));
+		position = mark.position;
+		end = reinterpret_cast<uintptr_t>(chunks) + DKMemoryPoolChunkSize();
+	}
+	else
+	{
+		position = 1;	// position > end, even Alloc(0) takes AllocSlow.
+		end = 0;
+	}
+}
+
+void DKArena::Reset(void)
+{
+	Mark mark = { NULL, 0, NULL };
+	Rewind(mark);
+}
+
+void DKArena::Release(void)
+{
+	Reset();
+	while (freeChunks)
+	{
+		Chunk* chunk = freeChunks;
+		freeChunks = chunk->next;
+		DKMemoryPoolChunkFree(chunk);
+	}
+}
+
+size_t DKArena::Size(void) const
+{
+	size_t size = NumberOfChunks() * DKMemoryPoolChunkSize();
+	for (LargeBlock* block = largeBlocks; block; block = block->next)
+		size += block->size;
+	return size;
+}
+
+size_t DKArena::UsedBytes(void) const
+{
+	size_t used = 0;
+	if (chunks)
+	{
+		used = position - reinterpret_cast<uintptr_t>(chunks);
+		for (Chunk* chunk = chunks->next; chunk; chunk = chunk->next)
+			used += chunk->used;
+	}
+	for (LargeBlock* block = largeBlocks; block; block = block->next)
+		used += block->size;
+	return used;
+}
+
+size_t DKArena::NumberOfChunks(void) const
+{
+	size_t count = 0;
+	for (Chunk* chunk = chunks; chunk; chunk = chunk->next)
+		count++;
+	for (Chunk* chunk = freeChunks; chunk; chunk = chunk->next)
+		count++;
+	return count;
+}
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ File: DKArena.h
+ Author: Hongtae Kim (tiff2766@gmail.com)
+
+ Copyright (c) 2015,2017 Hongtae Kim. All rights reserved.
+
+ NOTE: This is simplified 'Memory Allocator' part of DKGL.
+ Full version of DKGL: https://github.com/DKGL/DKGL
+
+ License: BSD-3
+*******************************************************************************/
+/*******************************************************************************
+
+ Copyright (c) 2015, Hongtae Kim.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of DKMalloc nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*******************************************************************************/
+
+#pragma once
+#include "DKDef.h"
+#include "DKMemory.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// DKArena
+// region allocator, allocates from whole memory pool chunks. (256KB)
+// memory is not released individually, it is released at once with
+// Rewind, Reset or Release.
+//
+//   DKArena arena;
+//   DKArena::Mark mark = arena.GetMark();
+//   void* p = arena.Alloc(100);
+//   arena.Rewind(mark);	// release all memory allocated after mark.
+//
+// Chunks are kept by Reset, Rewind for reuse, call Release to return them
+// to memory pool. This class is not thread-safe.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace DKFoundation
+{
+	class DKGL_API DKArena
+	{
+		struct Chunk;
+		struct LargeBlock;
+	public:
+		/// position of arena, allocations after mark can be released by Rewind.
+		struct Mark
+		{
+			Chunk* chunk;
+			uintptr_t position;
+			LargeBlock* largeBlocks;
+		};
+
+		DKArena(void);
+		~DKArena(void);
+
+		/// allocate memory with alignment. (power of two)
+		FORCEINLINE void* Alloc(size_t s, size_t alignment = 16)
+		{
+			DKASSERT_MEM_DEBUG((alignment & (alignment - 1)) == 0);
+			uintptr_t addr = (position + alignment - 1) & ~uintptr_t(alignment - 1);
+			if (addr >= position && addr <= end && s <= end - addr)
+			{
+				position = addr + s;
+				return reinterpret_cast<void*>(addr);
+			}
+			return AllocSlow(s, alignment);
+		}
+
+		Mark GetMark(void) const;
+		/// release memory allocated after mark. chunks are kept for reuse.
+		void Rewind(const Mark&);
+		/// release all memory. chunks are kept for reuse.
+		void Reset(void);
+		/// release all memory and chunks.
+		void Release(void);
+
+		/// total memory size of arena, including reserved chunks.
+		size_t Size(void) const;
+		/// allocated bytes, including alignment padding.
+		size_t UsedBytes(void) const;
+		size_t NumberOfChunks(void) const;
+
+		DKArena(const DKArena&) = delete;
+		DKArena& operator = (const DKArena&) = delete;
+
+	private:
+		void* AllocSlow(size_t, size_t);
+		void FreeLargeBlocks(LargeBlock*);
+
+		Chunk* chunks;			// chunks in use (current chunk at first)
+		Chunk* freeChunks;		// chunks can be reused.
+		LargeBlock* largeBlocks;
+		uintptr_t position;
+		uintptr_t end;
+	};
+}
@@ -59,6 +59,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 
 #if defined(DEBUG) || defined(_DEBUG)
 #define DKGL_DEBUG_ENABLED 1
@@ -80,6 +82,11 @@
 #define DKASSERT_STD_DEBUG(expr)			(void)0
 #endif
 
+// cache line size, data shared between threads are aligned with this.
+#ifndef DKGL_CACHE_LINE_SIZE
+#define DKGL_CACHE_LINE_SIZE 64
+#endif
+
 #ifndef DKGL_MEMORY_DEBUG
 #ifdef DKGL_DEBUG_ENABLED
 #define DKGL_MEMORY_DEBUG 1
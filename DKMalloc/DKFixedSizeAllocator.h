@@ -53,15 +53,148 @@
 
 namespace DKFoundation
 {
+	/// unit layout of DKFixedSizeAllocator, unit size is fixed at compile time.
+	template <unsigned int UnitSize, unsigned int Alignment, unsigned int MaxUnits>
+	class DKFixedSizeUnitLayout
+	{
+	protected:
+		enum : uint32_t { AlignedUnitSize = (UnitSize + (Alignment - 1)) & ~(Alignment - 1) };
+		union Unit
+		{
+			uint8_t data[AlignedUnitSize];
+			uint32_t nextUnitIndex;
+		};
+		static_assert((sizeof(Unit) % Alignment) == 0, "Invalid unit alignment");
+
+		enum : size_t { AlignedChunkSize = sizeof(Unit) * MaxUnits + Alignment - 1 };
+
+		FORCEINLINE static size_t UnitLength(void)			{ return UnitSize; }
+		FORCEINLINE static size_t UnitStride(void)			{ return sizeof(Unit); }
+		FORCEINLINE static size_t UnitAlignment(void)		{ return Alignment; }
+		FORCEINLINE static size_t ChunkUnits(size_t)		{ return MaxUnits; }
+		FORCEINLINE static size_t ChunkAllocationSize(size_t units)	{ return sizeof(Unit) * units + Alignment - 1; }
+		FORCEINLINE static size_t ChunkColorRange(size_t)	{ return 0; }	// no coloring
+		FORCEINLINE static size_t ChunkColorOffset(uintptr_t, size_t)	{ return 0; }
+		FORCEINLINE static size_t UnitIndex(size_t offset)	{ return offset / sizeof(Unit); }
+	};
+
+	/// unit layout of DKFixedSizeAllocator, unit size is given at runtime. (UnitSize = 0)
+	/// number of units per chunk is calculated from maxChunkSize, up to MaxUnits.
+	/// chunk size starts from minChunkSize, doubled as number of units grows.
+	/// unit area of chunk can be colored, start offset varies within spare bytes of chunk.
+	template <unsigned int Alignment, unsigned int MaxUnits>
+	class DKFixedSizeUnitLayout<0, Alignment, MaxUnits>
+	{
+	protected:
+		struct Unit
+		{
+			uint32_t nextUnitIndex;
+		};
+
+		enum : size_t { AlignedChunkSize = 0 };	// unknown at compile time
+
+		DKFixedSizeUnitLayout(size_t unitSize, size_t alignment, size_t minChunkSize, size_t maxChunkSize)
+		{
+			DKASSERT_MEM_DEBUG(unitSize > 0);
+			DKASSERT_MEM_DEBUG(alignment > 0 && (alignment & (alignment - 1)) == 0);
+			// stride is aligned with Unit as static layout does, chunk address
+			// is expected to be aligned with Unit. (malloc, VM)
+			size_t strideAlignment = Max(alignment, alignof(Unit));
+			unitLength = unitSize;
+			unitAlignment = alignment;
+			unitStride = (Max(unitSize, sizeof(Unit)) + (strideAlignment - 1)) & ~(strideAlignment - 1);
+			unitsPerChunk = (uint32_t)MaxUnitsForChunkSize(maxChunkSize);
+			this->minChunkSize = Max(Min(minChunkSize, maxChunkSize), size_t(1));
+			this->maxChunkSize = maxChunkSize;
+			minUnitsPerChunk = (uint32_t)MaxUnitsForChunkSize(this->minChunkSize);
+			colorStep = 0;
+			// UnitIndex divides offset by multiplying reciprocal,
+			// which is exact for multiples of unitStride less than 2^32.
+			DKASSERT_MEM_DEBUG(uint64_t(unitStride) * unitsPerChunk < (uint64_t(1) << 32));
+			reciprocal = ((uint64_t(1) << 32) + unitStride - 1) / unitStride;
+		}
+
+		FORCEINLINE size_t UnitLength(void) const			{ return unitLength; }
+		FORCEINLINE size_t UnitStride(void) const			{ return unitStride; }
+		FORCEINLINE size_t UnitAlignment(void) const		{ return unitAlignment; }
+		FORCEINLINE size_t ChunkAllocationSize(size_t units) const	{ return unitStride * units + unitAlignment - 1; }
+		/// units of new chunk, for numUnits units already allocated.
+		/// chunk size is doubled until new chunk has more units than numUnits.
+		FORCEINLINE size_t ChunkUnits(size_t numUnits) const
+		{
+			size_t chunkSize = minChunkSize;
+			size_t units = minUnitsPerChunk;
+			while (units <= numUnits && units < unitsPerChunk)
+			{
+				chunkSize = Min(chunkSize * 2, maxChunkSize);
+				units = MaxUnitsForChunkSize(chunkSize);
+			}
+			return units;
+		}
+		/// enable chunk coloring, offset is multiple of lineSize and
+		/// multiple of power of two factor of unitStride to keep alignment of units.
+		void SetColorStep(size_t lineSize)
+		{
+			colorStep = lineSize ? Max(lineSize, unitStride & (~unitStride + 1)) : 0;
+		}
+		/// spare bytes of chunk can be used for coloring, 0 if disabled.
+		FORCEINLINE size_t ChunkColorRange(size_t units) const
+		{
+			if (colorStep)
+			{
+				size_t chunkSize = minChunkSize;
+				while (MaxUnitsForChunkSize(chunkSize) < units && chunkSize < maxChunkSize)
+					chunkSize = Min(chunkSize * 2, maxChunkSize);
+				size_t s = ChunkAllocationSize(units);
+				if (chunkSize > s + colorStep)
+					return Min(chunkSize - s, size_t(MaxColorRange));
+			}
+			return 0;
+		}
+		/// color offset of chunk, neighbour chunks get different colors.
+		FORCEINLINE size_t ChunkColorOffset(uintptr_t chunk, size_t colorRange) const
+		{
+			return ((chunk / minChunkSize) % (colorRange / colorStep + 1)) * colorStep;
+		}
+		FORCEINLINE size_t UnitIndex(size_t offset) const
+		{
+			DKASSERT_MEM_DEBUG((offset % unitStride) == 0);
+			return (size_t)((uint64_t(offset) * reciprocal) >> 32);
+		}
+
+	private:
+		enum : size_t { MaxColorRange = 0x4000 };	// offset of chunk must fit in 16 bits.
+
+		FORCEINLINE size_t MaxUnitsForChunkSize(size_t chunkSize) const
+		{
+			size_t units = chunkSize > (unitAlignment - 1) ? (chunkSize - (unitAlignment - 1)) / unitStride : 0;
+			return Max(Min(units, size_t(MaxUnits)), size_t(1));
+		}
+
+		// used by every Alloc, Dealloc.
+		size_t unitStride;
+		uint64_t reciprocal;
+		size_t unitAlignment;
+		// used by chunk allocation only.
+		size_t unitLength;
+		uint32_t unitsPerChunk;
+		uint32_t minUnitsPerChunk;
+		size_t minChunkSize;
+		size_t maxChunkSize;
+		size_t colorStep;			// 0 if coloring disabled
+	};
+
 	/// @brief An allocator which can allocate memory of fixed length.
 	/// it is useful to template collection classes like DKMap, DKSet.
 	///
 	/// @tparam UnitSize       allocation size (fixed size)
+	///                        0 if unit size is given to constructor at runtime.
 	/// @tparam Alignment      byte alignment (default:1)
 	/// @tparam MaxUnits       max units per chunk (default:1024)
 	/// @tparam Lock           locking class
 	/// @tparam BaseAllocator  internal allocator (for internal-table, small size)
 	/// @tparam UnitAllocator  unit chunk allocator. (large size)
+	///                        it can be stateful, instance can be given to constructor.
 	template <
 		unsigned int UnitSize,				// allocation size (fixed size)
 		unsigned int Alignment = 1,			// byte alignment
@@ -70,24 +203,23 @@ namespace DKFoundation
 		typename BaseAllocator = DKMemoryDefaultAllocator, // info table allocator. (small)
 		typename UnitAllocator = DKMemoryDefaultAllocator  // unit chunk allocator. (large)
 	>
-	class DKFixedSizeAllocator
+	class DKFixedSizeAllocator : protected DKFixedSizeUnitLayout<UnitSize, Alignment, MaxUnits>
 	{
 		template <unsigned int, unsigned int, unsigned int, typename, typename, typename>
 			friend class DKFixedSizeAllocator;
-		static_assert(UnitSize > 0, "Size must be greater than zero.");
 		static_assert(MaxUnits > 1, "MaxUnits must be greater than one.");
+		static_assert(MaxUnits <= 0xffff, "MaxUnits must be less than 65536.");
 		static_assert(Alignment > 0, "Alignment must be greater than zero.");
 		static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be power of two.");
 
-		// maximum number of units per chunk.
-		enum : uint32_t { MaxUnitsPerChunk = MaxUnits };
-		enum : uint32_t { AlignedUnitSize = (UnitSize + (Alignment - 1)) & ~(Alignment - 1) };
-		union Unit
-		{
-			uint8_t data[AlignedUnitSize];
-			uint32_t nextUnitIndex;
-		};
-		static_assert((sizeof(Unit) % Alignment) == 0, "Invalid unit alignment");
+		using Layout = DKFixedSizeUnitLayout<UnitSize, Alignment, MaxUnits>;
+		using Unit = typename Layout::Unit;
+		using Layout::UnitAlignment;
+		using Layout::ChunkUnits;
+		using Layout::ChunkAllocationSize;
+		using Layout::ChunkColorRange;
+		using Layout::ChunkColorOffset;
+		using Layout::UnitIndex;
 
 		using Index = unsigned int;
 		enum : Index { EndOfUnits = ~Index(0) };
@@ -96,13 +228,13 @@ namespace DKFoundation
 		{
 			uintptr_t address;
 			Index freeUnitIndex;
+			Index untouchedUnitIndex;	// units from this index have never been used.
 			uint16_t offset;
 			uint16_t occupied;
+			uint16_t capacity;			// number of units in this chunk.
+			bool zeroFilled;			// chunk memory was zero-filled by UnitAllocator.
 		};
 
-		// size of all units per chunk. (in bytes)
-		enum : size_t { MaxUnitsPerChunkSize = sizeof(Unit) * MaxUnitsPerChunk };
-
 		using CriticalSection = DKCriticalSection < Lock > ;
 
 		template <unsigned int BaseAlignment> struct _RebindAlignment
@@ -114,7 +246,11 @@ namespace DKFoundation
 	public:
 		enum { FixedLength = UnitSize };
 		enum { BaseAlignment = Alignment };
-		enum { AlignedChunkSize = MaxUnitsPerChunkSize + Alignment - 1 };
+		enum : size_t { AlignedChunkSize = Layout::AlignedChunkSize };
+
+		/// unit size, and unit size including alignment padding.
+		using Layout::UnitLength;
+		using Layout::UnitStride;
 
 		template <unsigned int Align>
 		using RebindAlignment = typename _RebindAlignment<Align>::Allocator;
@@ -134,29 +270,45 @@ namespace DKFoundation
 
 		void* Alloc(size_t s)
 		{
-			DKASSERT_MEM_DEBUG(s <= FixedLength);
-			if (s > FixedLength)
+			return Alloc(s, NULL);
+		}
+
+		/// allocate unit, zeroFilled will be set true if the unit has never
+		/// been used since it was allocated from the UnitAllocator which
+		/// provides zero-filled memory. (VM pages)
+		void* Alloc(size_t s, bool* zeroFilled)
+		{
+			DKASSERT_MEM_DEBUG(s <= UnitLength());
+			if (s > UnitLength())
 				return NULL;
 
 			CriticalSection guard(lock);
 
-			if (cachedChunk && cachedChunk->occupied < MaxUnitsPerChunk)
+			if (cachedChunk && cachedChunk->occupied < cachedChunk->capacity)
 			{
-				uintptr_t ptr = AllocUnit(cachedChunk);
+				uintptr_t ptr = AllocUnit(cachedChunk, zeroFilled);
 				DKASSERT_MEM_DEBUG(ptr);
 				return reinterpret_cast<void*>(ptr);
 			}
-			// find unoccupied unit from each chunks.
+			// find unoccupied unit from each chunks. (sorted by address)
+			ChunkInfo* chunk = NULL;
 			for (size_t i = 0; i < numChunks; ++i)
 			{
-				if (chunkTable[i].occupied < MaxUnitsPerChunk)
+				if (chunkTable[i].occupied < chunkTable[i].capacity)
 				{
-					cachedChunk = &chunkTable[i];
-					uintptr_t ptr = AllocUnit(cachedChunk);
-					DKASSERT_MEM_DEBUG(ptr);
-					return reinterpret_cast<void*>(ptr);
+					if (chunk == NULL || IsPreferredChunk(&chunkTable[i], chunk))
+						chunk = &chunkTable[i];
+					if (chunkPolicy != DKMemoryChunkPolicyMostOccupied)
+						break;
 				}
 			}
+			if (chunk)
+			{
+				cachedChunk = chunk;
+				uintptr_t ptr = AllocUnit(cachedChunk, zeroFilled);
+				DKASSERT_MEM_DEBUG(ptr);
+				return reinterpret_cast<void*>(ptr);
+			}
 			// no space, create new chunk.
 			cachedChunk = NULL;
 			if (numChunks > 0)
@@ -208,11 +360,35 @@ namespace DKFoundation
 			DKASSERT_MEM_DEBUG(cachedChunk);
 			numChunks++;
 
-			uintptr_t ptr = AllocUnit(cachedChunk);
+			uintptr_t ptr = AllocUnit(cachedChunk, zeroFilled);
 			DKASSERT_MEM_DEBUG(ptr);
 			return reinterpret_cast<void*>(ptr);
 		}
 
+		/// allocate unit close to hint, from the chunk of hint (and the same page
+		/// if a free unit is found quickly). falls back to Alloc if hint was not
+		/// allocated from this allocator or the chunk is full.
+		void* AllocNear(void* hint, size_t s, bool* zeroFilled = NULL)
+		{
+			DKASSERT_MEM_DEBUG(s <= UnitLength());
+			if (s > UnitLength())
+				return NULL;
+
+			if (hint)
+			{
+				CriticalSection guard(lock);
+				uintptr_t addr = reinterpret_cast<uintptr_t>(hint);
+				ChunkInfo* info = numChunks > 0 ? FindChunkInfo(addr) : NULL;
+				if (info && info->occupied < info->capacity)
+				{
+					uintptr_t ptr = AllocUnitNear(info, addr, zeroFilled);
+					DKASSERT_MEM_DEBUG(ptr);
+					return reinterpret_cast<void*>(ptr);
+				}
+			}
+			return Alloc(s, zeroFilled);
+		}
+
 		void Dealloc(void* ptr)
 		{
 			if (ptr)
@@ -250,8 +426,7 @@ namespace DKFoundation
 					{
 						if (this->emptyChunks > 0)
 						{
-							if ((this->numChunks * MaxUnitsPerChunk) >=
-								(this->numAllocated + threshold + MaxUnitsPerChunk))
+							if (this->numUnits >= (this->numAllocated + threshold + ChunkUnits(0)))
 							{
 								size_t purged = PurgeInternal();
 								if (bytesPurged)
@@ -285,17 +460,18 @@ namespace DKFoundation
 		{
 			if (n > 0)
 			{
-				size_t numChunksRequired = 0;
-				while (numChunksRequired * MaxUnitsPerChunk < n)
+				CriticalSection guard(lock);
+				size_t numChunksRequired = numChunks;
+				for (size_t units = numUnits; units < n; units += ChunkUnits(units))
 					numChunksRequired++;
 
-				CriticalSection guard(lock);
 				if (numChunksRequired > numChunks)
 				{
 					ChunkInfo* table = (ChunkInfo*)BaseAllocator::Realloc(chunkTable, sizeof(ChunkInfo) * numChunksRequired);
 					if (table)
 					{
 						chunkTable = table;
+						cachedChunk = NULL;	// table could be moved.
 						for (size_t i = numChunks; i < numChunksRequired; ++i)
 						{
 							if (!AllocChunk(&chunkTable[i]))
@@ -310,8 +486,7 @@ namespace DKFoundation
 							// save last chunk's address.
 							uintptr_t addr = chunkTable[numChunks-1].address;
 							SortChunkTable();
-							if (cachedChunk == NULL || cachedChunk->occupied == MaxUnitsPerChunk)
-								cachedChunk = FindChunkInfo(addr);
+							cachedChunk = FindChunkInfo(addr);
 							DKASSERT_MEM_DEBUG(cachedChunk != NULL);
 						}
 					}
@@ -325,8 +500,7 @@ namespace DKFoundation
 			CriticalSection guard(lock);
 			if (this->emptyChunks > 0)
 			{
-				if ((this->numChunks * MaxUnitsPerChunk) >=
-					(this->numAllocated + threshold + MaxUnitsPerChunk))
+				if (this->numUnits >= (this->numAllocated + threshold + ChunkUnits(0)))
 					shouldPurge = true;
 			}
 			if (shouldPurge)
@@ -341,11 +515,68 @@ namespace DKFoundation
 			return PurgeInternal();
 		}
 
+		/// release all units and chunks at once.
+		/// all memory allocated from this allocator will be invalid.
+		size_t Clear(void)
+		{
+			CriticalSection guard(lock);
+			size_t bytesReleased = numUnits * UnitStride();
+			for (size_t i = 0; i < numChunks; ++i)
+			{
+				ChunkInfo* info = &chunkTable[i];
+				unitAllocator.Free(reinterpret_cast<void*>(info->address - info->offset));
+			}
+			if (chunkTable)
+				BaseAllocator::Free(chunkTable);
+			chunkTable = NULL;
+			cachedChunk = NULL;
+			numAllocated = 0;
+			numUnits = 0;
+			numChunks = 0;
+			emptyChunks = 0;
+			return bytesReleased;
+		}
+
+		/// enumerate all allocated units, enumerator will be called with each unit address.
+		/// allocator must not be modified during enumeration.
+		template <typename Enumerator> void EnumerateAllocatedUnits(Enumerator&& enumerator) const
+		{
+			CriticalSection guard(lock);
+			for (size_t i = 0; i < numChunks; ++i)
+			{
+				const ChunkInfo* info = &chunkTable[i];
+				if (info->occupied == 0)
+					continue;
+
+				uint8_t freeUnits[(MaxUnits + 7) / 8] = {};
+				for (Index index = info->freeUnitIndex; index != EndOfUnits; index = UnitAt(info->address, index)->nextUnitIndex)
+					freeUnits[index / 8] |= uint8_t(1 << (index % 8));
+
+				for (Index index = 0; index < info->untouchedUnitIndex; ++index)
+				{
+					if ((freeUnits[index / 8] & (1 << (index % 8))) == 0)
+						enumerator(static_cast<void*>(UnitAt(info->address, index)));
+				}
+			}
+		}
+
+		/// enumerate all chunks, enumerator will be called with chunk address
+		/// (allocated by UnitAllocator) and size in bytes up to the last unit.
+		template <typename Enumerator> void EnumerateChunks(Enumerator&& enumerator) const
+		{
+			CriticalSection guard(lock);
+			for (size_t i = 0; i < numChunks; ++i)
+			{
+				const ChunkInfo* info = &chunkTable[i];
+				enumerator(reinterpret_cast<void*>(info->address - info->offset), info->offset + info->capacity * UnitStride());
+			}
+		}
+
 		/// Total allocation size, including reserved space, in bytes
 		size_t Size(void) const
 		{
 			CriticalSection guard(lock);
-			return numChunks * (MaxUnitsPerChunkSize + sizeof(ChunkInfo));
+			return numUnits * UnitStride() + numChunks * sizeof(ChunkInfo);
 		}
 
 		size_t NumberOfAllocatedUnits(void) const
@@ -359,18 +590,71 @@ namespace DKFoundation
 		size_t NumberOfUnits(void) const
 		{
 			CriticalSection guard(lock);
-			return numChunks * MaxUnitsPerChunk;
+			return numUnits;
+		}
+
+		/// color chunks with multiple of lineSize, 0 to disable. (unit size given at runtime only)
+		/// new chunks start unit area at varying offset, within spare bytes of chunk.
+		void SetChunkColoring(size_t lineSize)
+		{
+			CriticalSection guard(lock);
+			Layout::SetColorStep(lineSize);
+		}
+
+		/// select chunk for next allocations by policy.
+		/// @see DKMemoryChunkPolicy
+		void SetChunkPolicy(DKMemoryChunkPolicy policy)
+		{
+			CriticalSection guard(lock);
+			chunkPolicy = static_cast<uint8_t>(policy);
+			cachedChunk = NULL;
 		}
 
 		DKFixedSizeAllocator(void)
-			: chunkTable(NULL)
+			: chunkPolicy(DKMemoryChunkPolicyDefault)
+			, chunkTable(NULL)
 			, cachedChunk(NULL)
 			, numAllocated(0)
+			, numUnits(0)
 			, numChunks(0)
 			, emptyChunks(0)
 		{
 		}
 
+		DKFixedSizeAllocator(const UnitAllocator& ua)
+			: chunkPolicy(DKMemoryChunkPolicyDefault)
+			, chunkTable(NULL)
+			, cachedChunk(NULL)
+			, numAllocated(0)
+			, numUnits(0)
+			, numChunks(0)
+			, emptyChunks(0)
+			, unitAllocator(ua)
+		{
+		}
+
+		/// allocator with unit size given at runtime. (UnitSize = 0)
+		/// chunk size will not exceed maxChunkSize, unless a unit is larger than maxChunkSize.
+		DKFixedSizeAllocator(size_t unitSize, size_t alignment, size_t maxChunkSize, const UnitAllocator& ua = UnitAllocator())
+			: DKFixedSizeAllocator(unitSize, alignment, maxChunkSize, maxChunkSize, ua)
+		{
+		}
+
+		/// allocator with unit size given at runtime, chunk size starts from minChunkSize
+		/// and doubles as allocator grows, up to maxChunkSize.
+		DKFixedSizeAllocator(size_t unitSize, size_t alignment, size_t minChunkSize, size_t maxChunkSize, const UnitAllocator& ua)
+			: Layout(unitSize, alignment, minChunkSize, maxChunkSize)
+			, chunkPolicy(DKMemoryChunkPolicyDefault)
+			, chunkTable(NULL)
+			, cachedChunk(NULL)
+			, numAllocated(0)
+			, numUnits(0)
+			, numChunks(0)
+			, emptyChunks(0)
+			, unitAllocator(ua)
+		{
+		}
+
 		~DKFixedSizeAllocator(void) noexcept(!DKGL_MEMORY_DEBUG)
 		{
 			DKASSERT_MEM_DEBUG(numAllocated == 0);
@@ -391,28 +675,41 @@ namespace DKFoundation
 		DKFixedSizeAllocator& operator = (const DKFixedSizeAllocator&) = delete;
 
 	private:
+		// UnitAllocator can provide Alloc(size_t, bool*) to report zero-filled memory.
+		template <typename T> FORCEINLINE static auto AllocChunkMemory(T& allocator, size_t s, bool* zeroFilled, int)
+			-> decltype(allocator.Alloc(s, zeroFilled))
+		{
+			return allocator.Alloc(s, zeroFilled);
+		}
+		template <typename T> FORCEINLINE static void* AllocChunkMemory(T& allocator, size_t s, bool* zeroFilled, long)
+		{
+			*zeroFilled = false;
+			return allocator.Alloc(s);
+		}
 		FORCEINLINE bool AllocChunk(ChunkInfo* info)
 		{
-			uintptr_t ptr = reinterpret_cast<uintptr_t>(UnitAllocator::Alloc(AlignedChunkSize));
+			bool zeroFilled = false;
+			size_t units = ChunkUnits(numUnits);
+			size_t colorRange = ChunkColorRange(units);
+			uintptr_t ptr = reinterpret_cast<uintptr_t>(AllocChunkMemory(unitAllocator, ChunkAllocationSize(units) + colorRange, &zeroFilled, 0));
 			if (ptr)
 			{
-				if (ptr % Alignment)
-				{
-					info->offset = Alignment - (ptr % Alignment);
-					info->address = ptr + info->offset;
-				}
-				else
-				{
-					info->offset = 0;
-					info->address = ptr;
-				}
-				DKASSERT_MEM_DEBUG((info->address % Alignment) == 0);
-				Unit* units = reinterpret_cast<Unit*>(info->address);
-				for (unsigned int i = 0, n = MaxUnitsPerChunk - 1; i < n; ++i)
-					units[i].nextUnitIndex = i + 1;
-				units[MaxUnitsPerChunk - 1].nextUnitIndex = EndOfUnits;
-				info->freeUnitIndex = 0;
+				size_t offset = 0;
+				if (ptr % UnitAlignment())
+					offset = UnitAlignment() - (ptr % UnitAlignment());
+				if (colorRange)
+					offset += ChunkColorOffset(ptr, colorRange);
+				DKASSERT_MEM_DEBUG(offset <= 0xffff);
+				info->offset = (uint16_t)offset;
+				info->address = ptr + offset;
+				DKASSERT_MEM_DEBUG((info->address % UnitAlignment()) == 0);
+				// units are linked lazily, chunk memory is not touched until used.
+				info->freeUnitIndex = EndOfUnits;
+				info->untouchedUnitIndex = 0;
 				info->occupied = 0;
+				info->capacity = (uint16_t)units;
+				info->zeroFilled = zeroFilled;
+				numUnits += units;
 				emptyChunks++;
 				return true;
 			}
@@ -420,61 +717,111 @@ namespace DKFoundation
 		}
 		FORCEINLINE void FreeChunk(ChunkInfo* info)
 		{
-			DKASSERT_MEM_DEBUG(info->freeUnitIndex != EndOfUnits);
 			DKASSERT_MEM_DEBUG(info->occupied == 0);
 
-			UnitAllocator::Free(reinterpret_cast<void*>(info->address - info->offset));
+			unitAllocator.Free(reinterpret_cast<void*>(info->address - info->offset));
 			info->address = 0;
+			DKASSERT_MEM_DEBUG(numUnits >= info->capacity);
+			numUnits -= info->capacity;
 
 			DKASSERT_MEM_DEBUG(emptyChunks > 0);
 			emptyChunks--;
 		}
-		FORCEINLINE uintptr_t AllocUnit(ChunkInfo* info)
+		FORCEINLINE uintptr_t AllocUnit(ChunkInfo* info, bool* zeroFilled)
 		{
+			Unit* unit = NULL;
 			if (info->freeUnitIndex != EndOfUnits)
 			{
-				// chunk has one or more unoccupied units.
-				Unit* unit = &reinterpret_cast<Unit*>(info->address)[info->freeUnitIndex];
+				// reuse unit from free-list.
+				unit = UnitAt(info->address, info->freeUnitIndex);
 				info->freeUnitIndex = unit->nextUnitIndex;
+				if (zeroFilled)
+					*zeroFilled = false;
+			}
+			else if (info->untouchedUnitIndex < info->capacity)
+			{
+				// take unit from never used area.
+				unit = UnitAt(info->address, info->untouchedUnitIndex);
+				info->untouchedUnitIndex++;
+				if (zeroFilled)
+					*zeroFilled = info->zeroFilled;
+			}
+			if (unit)
+				return OccupyUnit(info, unit);
+			return 0;
+		}
+		// take unit in the same page of addr, from free-list (first MaxScan units)
+		// or never used area. any unit of chunk if not found.
+		FORCEINLINE uintptr_t AllocUnitNear(ChunkInfo* info, uintptr_t addr, bool* zeroFilled)
+		{
+			enum { MaxScan = 64 };
+			const uintptr_t pageMask = ~uintptr_t(DKMemoryPageSize() - 1);
+			const uintptr_t page = addr & pageMask;
 
-				DKASSERT_MEM_DEBUG((reinterpret_cast<uintptr_t>(unit) % Alignment) == 0);
-
-				if (info->occupied == 0)
+			Index* link = &info->freeUnitIndex;
+			for (size_t n = 0; *link != EndOfUnits && n < MaxScan; ++n)
+			{
+				Unit* unit = UnitAt(info->address, *link);
+				if ((reinterpret_cast<uintptr_t>(unit) & pageMask) == page)
+				{
+					*link = unit->nextUnitIndex;
+					if (zeroFilled)
+						*zeroFilled = false;
+					return OccupyUnit(info, unit);
+				}
+				link = &unit->nextUnitIndex;
+			}
+			if (info->untouchedUnitIndex < info->capacity)
+			{
+				Unit* unit = UnitAt(info->address, info->untouchedUnitIndex);
+				if ((reinterpret_cast<uintptr_t>(unit) & pageMask) == page)
 				{
-					DKASSERT_MEM_DEBUG(emptyChunks > 0);
-					emptyChunks--;
+					info->untouchedUnitIndex++;
+					if (zeroFilled)
+						*zeroFilled = info->zeroFilled;
+					return OccupyUnit(info, unit);
 				}
-				info->occupied++;
-				numAllocated++;
+			}
+			return AllocUnit(info, zeroFilled);
+		}
+		FORCEINLINE uintptr_t OccupyUnit(ChunkInfo* info, Unit* unit)
+		{
+			DKASSERT_MEM_DEBUG((reinterpret_cast<uintptr_t>(unit) % UnitAlignment()) == 0);
 
-				return reinterpret_cast<uintptr_t>(unit);
+			if (info->occupied == 0)
+			{
+				DKASSERT_MEM_DEBUG(emptyChunks > 0);
+				emptyChunks--;
 			}
-			return NULL;
+			info->occupied++;
+			numAllocated++;
+
+			return reinterpret_cast<uintptr_t>(unit);
 		}
-		bool IsUnitOccupied(ChunkInfo* info, int index) const
+		bool IsUnitOccupied(ChunkInfo* info, Index index) const
 		{
-			const Unit* units = reinterpret_cast<const Unit*>(info->address);
+			if (index >= info->untouchedUnitIndex)
+				return false;
 			Index i = info->freeUnitIndex;
 			while (i != EndOfUnits)
 			{
 				if (i == index)
 					return false;
-				i = units[i].nextUnitIndex;
+				i = UnitAt(info->address, i)->nextUnitIndex;
 			}
 			return true;
 		}
 		FORCEINLINE void FreeUnit(ChunkInfo* info, uintptr_t p)
 		{
-			DKASSERT_MEM_DEBUG(p >= info->address && p < info->address + MaxUnitsPerChunkSize);
+			DKASSERT_MEM_DEBUG(p >= info->address && p < info->address + info->capacity * UnitStride());
 
-			int index = (int)((p - info->address) / sizeof(Unit));
-			DKASSERT_MEM_DEBUG(index >= 0 && index < MaxUnitsPerChunk);
+			Index index = (Index)UnitIndex(p - info->address);
+			DKASSERT_MEM_DEBUG(index < info->untouchedUnitIndex);
 
 			// IsUnitOccupied is slow, used only DEBUG build.
 			DKASSERT_MEM_DEBUG(IsUnitOccupied(info, index));	//debug check!
 
-			Unit* units = reinterpret_cast<Unit*>(info->address);
-			units[index].nextUnitIndex = info->freeUnitIndex;
+			UnitAt(info->address, index)->nextUnitIndex = info->freeUnitIndex;
 			info->freeUnitIndex = index;
 			DKASSERT_MEM_DEBUG(info->occupied > 0);
 			info->occupied--;
@@ -485,6 +832,10 @@ namespace DKFoundation
 			DKASSERT_MEM_DEBUG(numAllocated > 0);
 			numAllocated--;
 		}
+		FORCEINLINE Unit* UnitAt(uintptr_t address, Index index) const
+		{
+			return reinterpret_cast<Unit*>(address + index * UnitStride());
+		}
 		FORCEINLINE void SortChunkTable(void)
 		{
 			if (numChunks > 1)
@@ -505,17 +856,34 @@ namespace DKFoundation
 																			 return lhs < rhs.address;
 																		 }));
 			size_t index = ((pos - reinterpret_cast<uintptr_t>(&chunkTable[0])) / sizeof(ChunkInfo)) - 1;
-			if (index < numChunks && addr < chunkTable[index].address + MaxUnitsPerChunkSize)
+			if (index < numChunks && addr < chunkTable[index].address + chunkTable[index].capacity * UnitStride())
 				return &chunkTable[index];
 			return NULL;
 		}
+		// true if chunk should serve allocations rather than current one.
+		FORCEINLINE bool IsPreferredChunk(const ChunkInfo* chunk, const ChunkInfo* current) const
+		{
+			if (chunkPolicy == DKMemoryChunkPolicyLowestAddress)
+				return chunk->address < current->address;
+			if (chunkPolicy == DKMemoryChunkPolicyMostOccupied)
+			{
+				// occupancy in eighths, lower address if same. survivors are
+				// packed at low addresses, so backend regions can be released.
+				size_t level = size_t(chunk->occupied) * 8 / chunk->capacity;
+				size_t currentLevel = size_t(current->occupied) * 8 / current->capacity;
+				if (level == currentLevel)
+					return chunk->address < current->address;
+				return currentLevel < level;
+			}
+			return current->occupied < chunk->occupied;
+		}
 		FORCEINLINE bool FindChunkAndDealloc(uintptr_t addr)
 		{
 			ChunkInfo* info = FindChunkInfo(addr);
 			if (info)
 			{
 				FreeUnit(info, addr);
-				if (cachedChunk == NULL || cachedChunk->occupied < info->occupied)
+				if (cachedChunk == NULL || IsPreferredChunk(info, cachedChunk))
 					cachedChunk = info;
 				return true;
 			}
@@ -525,7 +893,7 @@ namespace DKFoundation
 		{
 			if (emptyChunks > 0)
 			{
-				size_t numChunksPrev = numChunks;
+				size_t numUnitsPrev = numUnits;
 				size_t availableChunks = 0;
 				for (size_t i = 0; i < numChunks; ++i)
 				{
@@ -553,9 +921,9 @@ namespace DKFoundation
 								if (chunkTable[i].address)
 								{
 									table[index] = chunkTable[i];
-									if (table[index].occupied < MaxUnitsPerChunk)
+									if (table[index].occupied < table[index].capacity)
 									{
-										if (cachedChunk == NULL || cachedChunk->occupied < table[index].occupied)
+										if (cachedChunk == NULL || IsPreferredChunk(&table[index], cachedChunk))
 											cachedChunk = &table[index];
 									}
 									index++;
@@ -580,7 +948,7 @@ namespace DKFoundation
 					}
 				}
 				DKASSERT_MEM_DEBUG(emptyChunks == 0);
-				return (numChunksPrev - numChunks) * MaxUnitsPerChunkSize;
+				return (numUnitsPrev - numUnits) * UnitStride();
 			}
 			return 0;
 		}
@@ -608,11 +976,16 @@ namespace DKFoundation
 			return *instance;
 		}
 		
+		// lock and states modified by Alloc, Dealloc are placed together,
+		// to be fit in one cache line with runtime layout.
+		Lock lock;
+		uint8_t chunkPolicy;		// DKMemoryChunkPolicy
 		ChunkInfo* chunkTable;
 		ChunkInfo* cachedChunk;		// for fast-alloc
 		size_t numAllocated;
+		size_t numUnits;			// total units of all chunks
 		size_t numChunks;
 		size_t emptyChunks;
-		Lock lock;
+		UnitAllocator unitAllocator;
 	};
 }
@@ -0,0 +1,867 @@
+/*******************************************************************************
+ File: DKHandleAllocator.h
+ Author: Hongtae Kim (tiff2766@gmail.com)
+
+ Copyright (c) 2015,2017 Hongtae Kim. All rights reserved.
+
+ NOTE: This is simplified 'Memory Allocator' part of DKGL.
+ Full version of DKGL: https://github.com/DKGL/DKGL
+
+ License: BSD-3
+*******************************************************************************/
+/*******************************************************************************
+
+ Copyright (c) 2015, Hongtae Kim.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of DKMalloc nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*******************************************************************************/
+
+#pragma once
+#include <string.h>
+#include <chrono>
+#include <type_traits>
+#include "DKDef.h"
+#include "DKSpinLock.h"
+#include "DKMemory.h"
+
+namespace DKFoundation
+{
+	/// @brief An allocator of fixed length units, addressed by 32-bit handles.
+	/// a handle consists of chunk index, unit index and optional generation tag.
+	/// Resolve converts handle to unit address in constant time, without locking.
+	///
+	/// @tparam UnitSize       allocation size (fixed size)
+	/// @tparam Alignment      byte alignment (default:1)
+	/// @tparam UnitBits       number of units per chunk is (1 << UnitBits) (default:10)
+	/// @tparam GenerationBits generation tag bits of handle, 0 to disable (default:0)
+	///                        Resolve returns NULL for stale handle if enabled.
+	/// @tparam Lock           locking class
+	/// @tparam BaseAllocator  internal allocator (for internal-table, small size)
+	/// @tparam UnitAllocator  unit chunk allocator. (large size)
+	///
+	/// @note
+	///   Handle 0 is null handle, never returned by AllocHandle.
+	///   Without generation tag, stale handle will be resolved to reused unit.
+	///   Chunk directory is reserved from VM (not committed) to keep Resolve lock-free.
+	template <
+		unsigned int UnitSize,				// allocation size (fixed size)
+		unsigned int Alignment = 1,			// byte alignment
+		unsigned int UnitBits = 10,			// log2 of units per chunk
+		unsigned int GenerationBits = 0,	// generation tag bits
+		typename Lock = DKSpinLock,
+		typename BaseAllocator = DKMemoryDefaultAllocator, // info table allocator. (small)
+		typename UnitAllocator = DKMemoryDefaultAllocator  // unit chunk allocator. (large)
+	>
+	class DKHandleAllocator
+	{
+		static_assert(UnitSize > 0, "Size must be greater than zero.");
+		static_assert(Alignment > 0, "Alignment must be greater than zero.");
+		static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be power of two.");
+		static_assert(UnitBits > 0 && UnitBits <= 16, "UnitBits must be between 1 and 16.");
+		static_assert(GenerationBits <= 16, "GenerationBits must be 16 or less.");
+		static_assert(UnitBits + GenerationBits <= 24, "Not enough bits for chunk index.");
+
+	public:
+		using Handle = uint32_t;
+		enum : Handle { NullHandle = 0 };
+
+		enum : uint32_t { UnitsPerChunk = 1U << UnitBits };
+		enum : uint32_t { MaxChunks = (1U << (32 - UnitBits - GenerationBits)) - 1 };
+		enum { FixedLength = UnitSize };
+
+	private:
+		enum : uint32_t { UnitShift = GenerationBits, ChunkShift = UnitBits + GenerationBits };
+		enum : uint32_t { UnitMask = UnitsPerChunk - 1, GenerationMask = (1U << GenerationBits) - 1 };
+
+		enum : uint32_t { AlignedUnitSize = (UnitSize + (Alignment - 1)) & ~(Alignment - 1) };
+		union Unit
+		{
+			uint8_t data[AlignedUnitSize];
+			uint32_t nextUnitIndex;
+		};
+		static_assert((sizeof(Unit) % Alignment) == 0, "Invalid unit alignment");
+
+		using Index = uint32_t;
+		enum : Index { EndOfUnits = ~Index(0) };
+		using Generation = typename std::conditional<(GenerationBits > 8), uint16_t, uint8_t>::type;
+
+		// chunk layout: units, generation of each units (if enabled)
+		enum : size_t { UnitsPerChunkSize = sizeof(Unit) * UnitsPerChunk };
+		enum : size_t { GenerationsSize = GenerationBits ? sizeof(Generation) * UnitsPerChunk : 0 };
+		enum : size_t { AlignedChunkSize = UnitsPerChunkSize + GenerationsSize + Alignment - 1 };
+
+		struct ChunkInfo
+		{
+			uintptr_t memory;		// allocated by UnitAllocator, 0 if chunk was purged.
+			Index freeUnitIndex;
+			Index untouchedUnitIndex;	// units from this index have never been used.
+			Index occupied;
+			Generation generation;	// initial generation, increased every time chunk is created.
+		};
+
+		using CriticalSection = DKCriticalSection<Lock>;
+
+	public:
+		/// allocate unit, returns NullHandle if out of memory.
+		Handle AllocHandle(void)
+		{
+			CriticalSection guard(lock);
+			if (cachedChunk == 0 || chunkTable[cachedChunk].occupied == UnitsPerChunk)
+			{
+				cachedChunk = FindAvailableChunk();
+				if (cachedChunk == 0)
+					return NullHandle;
+			}
+			return AllocUnit(cachedChunk);
+		}
+
+		/// release unit. stale handle is ignored if generation tag is enabled.
+		void FreeHandle(Handle h)
+		{
+			if (h == NullHandle)
+				return;
+
+			Index chunk = h >> ChunkShift;
+			Index index = (h >> UnitShift) & UnitMask;
+
+			CriticalSection guard(lock);
+			DKASSERT_MEM_DESC_DEBUG(chunk <= numChunkSlots && directory[chunk], "Invalid handle!");
+			if (chunk > numChunkSlots || directory[chunk] == 0)
+				return;
+
+			ChunkInfo* info = &chunkTable[chunk];
+			DKASSERT_MEM_DEBUG(index < info->untouchedUnitIndex);
+			if (GenerationBits > 0)
+			{
+				Generation* generations = ChunkGenerations(directory[chunk]);
+				DKASSERT_MEM_DESC_DEBUG(generations[index] == Generation(h & GenerationMask), "Stale handle!");
+				if (generations[index] != Generation(h & GenerationMask))
+					return;
+				generations[index] = Generation((generations[index] + 1) & GenerationMask);
+			}
+			// IsUnitOccupied is slow, used only DEBUG build.
+			DKASSERT_MEM_DEBUG(IsUnitOccupied(chunk, index));
+
+			UnitAt(directory[chunk], index)->nextUnitIndex = info->freeUnitIndex;
+			info->freeUnitIndex = index;
+			DKASSERT_MEM_DEBUG(info->occupied > 0);
+			info->occupied--;
+			if (info->occupied == 0)
+				emptyChunks++;
+
+			DKASSERT_MEM_DEBUG(numAllocated > 0);
+			numAllocated--;
+
+			if (cachedChunk == 0 || chunkTable[cachedChunk].occupied < info->occupied)
+				cachedChunk = chunk;
+		}
+
+		/// returns unit address of handle, NULL for null handle or stale handle.
+		/// this function does not lock, handle must not be released while resolving.
+		FORCEINLINE void* Resolve(Handle h) const
+		{
+			uintptr_t address = directory[h >> ChunkShift];
+			if (address == 0)
+				return NULL;
+			Index index = (h >> UnitShift) & UnitMask;
+			if (GenerationBits > 0)
+			{
+				if (ChunkGenerations(address)[index] != Generation(h & GenerationMask))
+					return NULL;
+			}
+			return UnitAt(address, index);
+		}
+
+		/// allocate unit from given chunk, returns NullHandle if chunk is full.
+		Handle AllocHandleInChunk(uint32_t chunk)
+		{
+			CriticalSection guard(lock);
+			if (chunk == 0 || chunk > numChunkSlots || directory[chunk] == 0)
+				return NullHandle;
+			if (chunkTable[chunk].occupied == UnitsPerChunk)
+				return NullHandle;
+			return AllocUnit(chunk);
+		}
+
+		/// chunk index of handle.
+		FORCEINLINE static uint32_t ChunkOfHandle(Handle h)
+		{
+			return h >> ChunkShift;
+		}
+
+		/// enumerate chunks, enumerator will be called with chunk index and
+		/// number of allocated units of each chunk.
+		template <typename Enumerator> void EnumerateChunks(Enumerator&& enumerator) const
+		{
+			CriticalSection guard(lock);
+			for (Index chunk = 1; chunk <= numChunkSlots; ++chunk)
+			{
+				if (directory[chunk])
+					enumerator(uint32_t(chunk), size_t(chunkTable[chunk].occupied));
+			}
+		}
+
+		/// enumerate handles of allocated units in given chunk.
+		/// allocator must not be modified during enumeration.
+		template <typename Enumerator> void EnumerateAllocatedHandles(uint32_t chunk, Enumerator&& enumerator) const
+		{
+			CriticalSection guard(lock);
+			if (chunk == 0 || chunk > numChunkSlots || directory[chunk] == 0)
+				return;
+
+			const ChunkInfo* info = &chunkTable[chunk];
+			if (info->occupied == 0)
+				return;
+
+			uintptr_t address = directory[chunk];
+			uint8_t freeUnits[(UnitsPerChunk + 7) / 8] = {};
+			for (Index index = info->freeUnitIndex; index != EndOfUnits; index = UnitAt(address, index)->nextUnitIndex)
+				freeUnits[index / 8] |= uint8_t(1 << (index % 8));
+
+			for (Index index = 0; index < info->untouchedUnitIndex; ++index)
+			{
+				if ((freeUnits[index / 8] & (1 << (index % 8))) == 0)
+				{
+					Handle h = (chunk << ChunkShift) | (index << UnitShift);
+					if (GenerationBits > 0)
+						h |= ChunkGenerations(address)[index];
+					enumerator(h);
+				}
+			}
+		}
+
+		void Reserve(size_t n)		///< preallocate
+		{
+			CriticalSection guard(lock);
+			while ((numChunks * UnitsPerChunk) < n)
+			{
+				if (CreateChunk() == 0)
+					break;		// out of memory!
+			}
+		}
+
+		/// delete unoccupied chunks
+		size_t Purge(void)
+		{
+			CriticalSection guard(lock);
+			size_t purged = 0;
+			if (emptyChunks > 0)
+			{
+				for (Index chunk = 1; chunk <= numChunkSlots; ++chunk)
+				{
+					if (directory[chunk] && chunkTable[chunk].occupied == 0)
+					{
+						FreeChunk(chunk);
+						purged += AlignedChunkSize;
+					}
+				}
+				DKASSERT_MEM_DEBUG(emptyChunks == 0);
+			}
+			return purged;
+		}
+
+		/// release all units and chunks at once.
+		/// all handles allocated from this allocator will be invalid.
+		size_t Clear(void)
+		{
+			CriticalSection guard(lock);
+			size_t bytesReleased = numChunks * AlignedChunkSize;
+			for (Index chunk = 1; chunk <= numChunkSlots; ++chunk)
+			{
+				if (directory[chunk])
+				{
+					if (chunkTable[chunk].occupied > 0)
+					{
+						chunkTable[chunk].occupied = 0;
+						emptyChunks++;
+					}
+					FreeChunk(chunk);
+				}
+			}
+			DKASSERT_MEM_DEBUG(numChunks == 0);
+			DKASSERT_MEM_DEBUG(emptyChunks == 0);
+			cachedChunk = 0;
+			numAllocated = 0;
+			return bytesReleased;
+		}
+
+		/// Total allocation size, including reserved space, in bytes
+		size_t Size(void) const
+		{
+			CriticalSection guard(lock);
+			return numChunks * AlignedChunkSize + (numChunkSlots + 1) * sizeof(ChunkInfo);
+		}
+
+		size_t NumberOfAllocatedUnits(void) const
+		{
+			CriticalSection guard(lock);
+			return numAllocated;
+		}
+
+		/// total units in this container.
+		size_t NumberOfUnits(void) const
+		{
+			CriticalSection guard(lock);
+			return numChunks * UnitsPerChunk;
+		}
+
+		DKHandleAllocator(void)
+			: DKHandleAllocator(UnitAllocator())
+		{
+		}
+
+		DKHandleAllocator(const UnitAllocator& ua)
+			: directory(NULL)
+			, directoryCapacity(0)
+			, chunkTable(NULL)
+			, numChunkSlots(0)
+			, numChunks(0)
+			, emptyChunks(0)
+			, numAllocated(0)
+			, cachedChunk(0)
+			, unitAllocator(ua)
+		{
+			// directory[0] is always zero, for NullHandle.
+			directory = reinterpret_cast<uintptr_t*>(DKMemoryPageReserve(NULL, sizeof(uintptr_t) * (size_t(MaxChunks) + 1)));
+			DKASSERT_MEM_DEBUG(directory != NULL);
+			GrowDirectory(0);
+		}
+
+		~DKHandleAllocator(void) noexcept(!DKGL_MEMORY_DEBUG)
+		{
+			DKASSERT_MEM_DEBUG(numAllocated == 0);
+			for (Index chunk = 1; chunk <= numChunkSlots; ++chunk)
+			{
+				if (directory[chunk])
+				{
+					DKASSERT_MEM_DEBUG(chunkTable[chunk].occupied == 0);
+					FreeChunk(chunk);
+				}
+			}
+			DKASSERT_MEM_DEBUG(emptyChunks == 0);
+			if (chunkTable)
+				BaseAllocator::Free(chunkTable);
+			if (directory)
+				DKMemoryPageRelease(directory);
+		}
+
+		DKHandleAllocator(const DKHandleAllocator&) = delete;
+		DKHandleAllocator& operator = (const DKHandleAllocator&) = delete;
+
+	private:
+		FORCEINLINE static Unit* UnitAt(uintptr_t address, Index index)
+		{
+			return &reinterpret_cast<Unit*>(address)[index];
+		}
+		FORCEINLINE static Generation* ChunkGenerations(uintptr_t address)
+		{
+			return reinterpret_cast<Generation*>(address + UnitsPerChunkSize);
+		}
+		FORCEINLINE Handle AllocUnit(Index chunk)
+		{
+			ChunkInfo* info = &chunkTable[chunk];
+			uintptr_t address = directory[chunk];
+			Index index;
+			if (info->freeUnitIndex != EndOfUnits)
+			{
+				// reuse unit from free-list.
+				index = info->freeUnitIndex;
+				info->freeUnitIndex = UnitAt(address, index)->nextUnitIndex;
+			}
+			else
+			{
+				// take unit from never used area.
+				DKASSERT_MEM_DEBUG(info->untouchedUnitIndex < UnitsPerChunk);
+				index = info->untouchedUnitIndex++;
+			}
+			if (info->occupied == 0)
+			{
+				DKASSERT_MEM_DEBUG(emptyChunks > 0);
+				emptyChunks--;
+			}
+			info->occupied++;
+			numAllocated++;
+
+			Handle h = (chunk << ChunkShift) | (index << UnitShift);
+			if (GenerationBits > 0)
+				h |= ChunkGenerations(address)[index];
+			return h;
+		}
+		bool IsUnitOccupied(Index chunk, Index index) const
+		{
+			const ChunkInfo* info = &chunkTable[chunk];
+			if (index >= info->untouchedUnitIndex)
+				return false;
+			for (Index i = info->freeUnitIndex; i != EndOfUnits; i = UnitAt(directory[chunk], i)->nextUnitIndex)
+			{
+				if (i == index)
+					return false;
+			}
+			return true;
+		}
+		Index FindAvailableChunk(void)
+		{
+			for (Index chunk = 1; chunk <= numChunkSlots; ++chunk)
+			{
+				if (directory[chunk] && chunkTable[chunk].occupied < UnitsPerChunk)
+					return chunk;
+			}
+			return CreateChunk();
+		}
+		// commit directory pages for given chunk index.
+		bool GrowDirectory(Index chunk)
+		{
+			if (directory == NULL)
+				return false;
+			if (chunk >= directoryCapacity)
+			{
+				size_t pageSize = DKMemoryPageSize();
+				size_t committed = directoryCapacity * sizeof(uintptr_t);
+				size_t required = (size_t(chunk) + 1) * sizeof(uintptr_t);
+				required = ((required + pageSize - 1) / pageSize) * pageSize;
+				DKMemoryPageCommit(reinterpret_cast<uint8_t*>(directory) + committed, required - committed);
+				directoryCapacity = required / sizeof(uintptr_t);
+			}
+			return true;
+		}
+		// create chunk at empty slot (purged), or new slot.
+		Index CreateChunk(void)
+		{
+			Index chunk = 0;
+			if (numChunks < numChunkSlots)
+			{
+				for (Index i = 1; i <= numChunkSlots; ++i)
+				{
+					if (directory[i] == 0)
+					{
+						chunk = i;
+						break;
+					}
+				}
+			}
+			else if (numChunkSlots < MaxChunks && GrowDirectory(numChunkSlots + 1))
+			{
+				ChunkInfo* table = (ChunkInfo*)BaseAllocator::Realloc(chunkTable, sizeof(ChunkInfo) * (numChunkSlots + 2));
+				if (table == NULL) // out of memory!
+					return 0;
+				chunkTable = table;
+				chunk = ++numChunkSlots;
+				chunkTable[chunk].memory = 0;
+				chunkTable[chunk].generation = 0;
+			}
+			if (chunk == 0)
+				return 0;
+
+			uintptr_t ptr = reinterpret_cast<uintptr_t>(unitAllocator.Alloc(AlignedChunkSize));
+			if (ptr == 0) // out of memory!
+				return 0;
+
+			ChunkInfo* info = &chunkTable[chunk];
+			info->memory = ptr;
+			info->freeUnitIndex = EndOfUnits;
+			info->untouchedUnitIndex = 0;
+			info->occupied = 0;
+			uintptr_t address = (ptr + (Alignment - 1)) & ~uintptr_t(Alignment - 1);
+			if (GenerationBits > 0)
+			{
+				// handles of previous chunk at this slot must not be matched.
+				info->generation = Generation((info->generation + 1) & GenerationMask);
+				Generation* generations = ChunkGenerations(address);
+				for (Index i = 0; i < UnitsPerChunk; ++i)
+					generations[i] = info->generation;
+			}
+			directory[chunk] = address;
+			numChunks++;
+			emptyChunks++;
+			return chunk;
+		}
+		void FreeChunk(Index chunk)
+		{
+			ChunkInfo* info = &chunkTable[chunk];
+			DKASSERT_MEM_DEBUG(info->occupied == 0);
+			directory[chunk] = 0;
+			unitAllocator.Free(reinterpret_cast<void*>(info->memory));
+			info->memory = 0;
+			if (cachedChunk == chunk)
+				cachedChunk = 0;
+
+			DKASSERT_MEM_DEBUG(numChunks > 0);
+			DKASSERT_MEM_DEBUG(emptyChunks > 0);
+			numChunks--;
+			emptyChunks--;
+		}
+
+		uintptr_t* directory;		// chunk addresses, indexed by handle. (reserved VM)
+		size_t directoryCapacity;	// committed entries of directory
+		ChunkInfo* chunkTable;		// indexed by chunk, same as directory
+		Index numChunkSlots;
+		size_t numChunks;
+		size_t emptyChunks;
+		size_t numAllocated;
+		Index cachedChunk;			// for fast-alloc
+		Lock lock;
+		UnitAllocator unitAllocator;
+	};
+
+	/// @brief Handle allocator which can compact sparse chunks.
+	/// units are addressed through a handle table, Compact moves units of the
+	/// sparsest chunks into fuller chunks, updates handle table and releases
+	/// emptied chunks. Compact runs incrementally within given time budget.
+	///
+	/// @tparam UnitSize       allocation size (fixed size)
+	/// @tparam Alignment      byte alignment (default:1)
+	/// @tparam UnitBits       number of units per chunk is (1 << UnitBits) (default:10)
+	/// @tparam HandleBits     max number of handles is (1 << HandleBits) - 1 (default:24)
+	/// @tparam Lock           locking class
+	/// @tparam BaseAllocator  internal allocator (for internal-table, small size)
+	/// @tparam UnitAllocator  unit chunk allocator. (large size)
+	///
+	/// @note
+	///   Units are moved with memcpy, objects must be trivially relocatable
+	///   and must be referenced only by handles.
+	///   Address returned by Resolve is valid until next Compact.
+	template <
+		unsigned int UnitSize,
+		unsigned int Alignment = 1,
+		unsigned int UnitBits = 10,
+		unsigned int HandleBits = 24,
+		typename Lock = DKSpinLock,
+		typename BaseAllocator = DKMemoryDefaultAllocator,
+		typename UnitAllocator = DKMemoryDefaultAllocator
+	>
+	class DKCompactingHandleAllocator
+	{
+		static_assert(HandleBits > 0 && HandleBits <= 30, "HandleBits must be between 1 and 30.");
+
+		// each unit has handle of owner at the end of unit, to update handle table.
+		enum : uint32_t { OwnerOffset = (UnitSize + 3) & ~3U };
+		enum : uint32_t { StorageAlignment = Alignment > 4 ? Alignment : 4 };
+		using Storage = DKHandleAllocator<OwnerOffset + 4, StorageAlignment, UnitBits, 0, DKDummyLock, BaseAllocator, UnitAllocator>;
+		using Location = typename Storage::Handle;
+		using CriticalSection = DKCriticalSection<Lock>;
+
+	public:
+		using Handle = uint32_t;
+		enum : Handle { NullHandle = 0 };
+		enum : uint32_t { MaxHandles = (1U << HandleBits) - 1 };
+		enum : uint32_t { UnitsPerChunk = Storage::UnitsPerChunk };
+		enum { FixedLength = UnitSize };
+
+		/// allocate unit, returns NullHandle if out of memory.
+		Handle AllocHandle(void)
+		{
+			CriticalSection guard(lock);
+			Handle h = NullHandle;
+			if (numFreeHandles > 0)
+			{
+				h = freeHandles[--numFreeHandles];
+			}
+			else if (numHandles < MaxHandles && GrowHandleTable(numHandles + 1))
+			{
+				h = ++numHandles;
+			}
+			if (h == NullHandle)
+				return NullHandle;
+
+			Location loc = storage.AllocHandle();
+			if (loc == Storage::NullHandle) // out of memory!
+			{
+				freeHandles[numFreeHandles++] = h;
+				return NullHandle;
+			}
+			SetOwner(loc, h);
+			handleTable[h] = loc;
+			numAllocated++;
+			return h;
+		}
+
+		void FreeHandle(Handle h)
+		{
+			if (h == NullHandle)
+				return;
+
+			CriticalSection guard(lock);
+			DKASSERT_MEM_DESC_DEBUG(h <= numHandles && handleTable[h], "Invalid handle!");
+			if (h > numHandles || handleTable[h] == Storage::NullHandle)
+				return;
+
+			storage.FreeHandle(handleTable[h]);
+			handleTable[h] = Storage::NullHandle;
+			// freeHandles has capacity of numHandles.
+			freeHandles[numFreeHandles++] = h;
+			DKASSERT_MEM_DEBUG(numAllocated > 0);
+			numAllocated--;
+		}
+
+		/// returns unit address of handle, NULL for null handle or released handle.
+		/// address is valid until next Compact.
+		FORCEINLINE void* Resolve(Handle h) const
+		{
+			return storage.Resolve(handleTable[h]);
+		}
+
+		/// move units of sparse chunks (less than half occupied) into fuller
+		/// chunks and release emptied chunks, until done or timeBudget elapsed.
+		/// returns true if compaction is done, false if more steps are needed.
+		bool Compact(double timeBudget)
+		{
+			using Clock = std::chrono::steady_clock;
+			Clock::time_point deadline = Clock::now() +
+				std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timeBudget));
+
+			CriticalSection guard(lock);
+			for (;;)
+			{
+				if (compactSource == 0)
+				{
+					storage.Purge();
+					compactSource = SelectSparsestChunk();
+					compactDestination = 0;
+					if (compactSource == 0)
+						return true;
+				}
+
+				// collect handles first, storage cannot be modified while enumerating.
+				size_t count = 0;
+				storage.EnumerateAllocatedHandles(compactSource, [&](Location loc)
+				{
+					compactBuffer[count++] = loc;
+				});
+				for (size_t i = 0; i < count; ++i)
+				{
+					if ((i % 64) == 63 && Clock::now() >= deadline)
+						return false;
+					if (!MoveUnit(compactBuffer[i]))
+					{
+						// no space in other chunks, stop compaction of this chunk.
+						compactSource = 0;
+						return true;
+					}
+				}
+				compactSource = 0;
+				if (Clock::now() >= deadline)
+					return false;
+			}
+		}
+
+		void Reserve(size_t n)		///< preallocate
+		{
+			CriticalSection guard(lock);
+			storage.Reserve(n);
+		}
+
+		/// delete unoccupied chunks
+		size_t Purge(void)
+		{
+			CriticalSection guard(lock);
+			return storage.Purge();
+		}
+
+		/// release all units and chunks at once.
+		/// all handles allocated from this allocator will be invalid.
+		size_t Clear(void)
+		{
+			CriticalSection guard(lock);
+			for (Handle h = 1; h <= numHandles; ++h)
+			{
+				if (handleTable[h] != Storage::NullHandle)
+				{
+					handleTable[h] = Storage::NullHandle;
+					freeHandles[numFreeHandles++] = h;
+				}
+			}
+			numAllocated = 0;
+			compactSource = 0;
+			return storage.Clear();
+		}
+
+		/// Total allocation size, including reserved space, in bytes
+		size_t Size(void) const
+		{
+			CriticalSection guard(lock);
+			return storage.Size() + numHandles * sizeof(Location) * 2;
+		}
+
+		size_t NumberOfAllocatedUnits(void) const
+		{
+			CriticalSection guard(lock);
+			return numAllocated;
+		}
+
+		/// total units in this container.
+		size_t NumberOfUnits(void) const
+		{
+			CriticalSection guard(lock);
+			return storage.NumberOfUnits();
+		}
+
+		DKCompactingHandleAllocator(void)
+			: DKCompactingHandleAllocator(UnitAllocator())
+		{
+		}
+
+		DKCompactingHandleAllocator(const UnitAllocator& ua)
+			: storage(ua)
+			, handleTable(NULL)
+			, handleTableCapacity(0)
+			, freeHandles(NULL)
+			, numHandles(0)
+			, numFreeHandles(0)
+			, numAllocated(0)
+			, compactSource(0)
+			, compactDestination(0)
+			, compactBuffer(NULL)
+		{
+			// handleTable[0] is always zero, for NullHandle.
+			handleTable = reinterpret_cast<Location*>(DKMemoryPageReserve(NULL, sizeof(Location) * (size_t(MaxHandles) + 1)));
+			DKASSERT_MEM_DEBUG(handleTable != NULL);
+			GrowHandleTable(0);
+		}
+
+		~DKCompactingHandleAllocator(void) noexcept(!DKGL_MEMORY_DEBUG)
+		{
+			DKASSERT_MEM_DEBUG(numAllocated == 0);
+			if (freeHandles)
+				BaseAllocator::Free(freeHandles);
+			if (compactBuffer)
+				BaseAllocator::Free(compactBuffer);
+			if (handleTable)
+				DKMemoryPageRelease(handleTable);
+		}
+
+		DKCompactingHandleAllocator(const DKCompactingHandleAllocator&) = delete;
+		DKCompactingHandleAllocator& operator = (const DKCompactingHandleAllocator&) = delete;
+
+	private:
+		FORCEINLINE void SetOwner(Location loc, Handle h)
+		{
+			uint8_t* p = reinterpret_cast<uint8_t*>(storage.Resolve(loc));
+			*reinterpret_cast<Handle*>(p + OwnerOffset) = h;
+		}
+		FORCEINLINE Handle Owner(Location loc) const
+		{
+			const uint8_t* p = reinterpret_cast<const uint8_t*>(storage.Resolve(loc));
+			return *reinterpret_cast<const Handle*>(p + OwnerOffset);
+		}
+		// commit handle table pages for given handle, free-list grows together.
+		bool GrowHandleTable(Handle h)
+		{
+			if (handleTable == NULL)
+				return false;
+			if (h >= handleTableCapacity)
+			{
+				size_t pageSize = DKMemoryPageSize();
+				size_t committed = handleTableCapacity * sizeof(Location);
+				size_t required = Max((size_t(h) + 1) * sizeof(Location), committed * 2);
+				required = ((required + pageSize - 1) / pageSize) * pageSize;
+				required = Min(required, sizeof(Location) * (size_t(MaxHandles) + 1));
+
+				Handle* handles = (Handle*)BaseAllocator::Realloc(freeHandles, required);
+				if (handles == NULL) // out of memory!
+					return false;
+				freeHandles = handles;
+
+				DKMemoryPageCommit(reinterpret_cast<uint8_t*>(handleTable) + committed, required - committed);
+				handleTableCapacity = required / sizeof(Location);
+			}
+			return true;
+		}
+		// sparsest chunk, if its units can be moved into other chunks.
+		uint32_t SelectSparsestChunk(void)
+		{
+			uint32_t chunk = 0;
+			size_t occupied = UnitsPerChunk / 2;
+			size_t numChunks = 0;
+			storage.EnumerateChunks([&](uint32_t c, size_t n)
+			{
+				numChunks++;
+				if (n > 0 && n < occupied)
+				{
+					chunk = c;
+					occupied = n;
+				}
+			});
+			// free units in other chunks must be enough.
+			if (chunk && (numChunks - 1) * UnitsPerChunk >= numAllocated)
+			{
+				if (compactBuffer == NULL)
+					compactBuffer = (Location*)BaseAllocator::Alloc(sizeof(Location) * UnitsPerChunk);
+				if (compactBuffer)
+					return chunk;
+			}
+			return 0;
+		}
+		// fullest chunk except compactSource, which is not full.
+		uint32_t SelectDestinationChunk(void)
+		{
+			uint32_t chunk = 0;
+			size_t occupied = 0;
+			storage.EnumerateChunks([&](uint32_t c, size_t n)
+			{
+				if (c != compactSource && n < UnitsPerChunk && (chunk == 0 || n > occupied))
+				{
+					chunk = c;
+					occupied = n;
+				}
+			});
+			return chunk;
+		}
+		bool MoveUnit(Location loc)
+		{
+			Location newLoc = Storage::NullHandle;
+			if (compactDestination)
+				newLoc = storage.AllocHandleInChunk(compactDestination);
+			if (newLoc == Storage::NullHandle)
+			{
+				compactDestination = SelectDestinationChunk();
+				if (compactDestination)
+					newLoc = storage.AllocHandleInChunk(compactDestination);
+				if (newLoc == Storage::NullHandle)
+					return false;
+			}
+			Handle h = Owner(loc);
+			DKASSERT_MEM_DEBUG(h > 0 && h <= numHandles && handleTable[h] == loc);
+			memcpy(storage.Resolve(newLoc), storage.Resolve(loc), OwnerOffset + sizeof(Handle));
+			handleTable[h] = newLoc;
+			storage.FreeHandle(loc);
+			return true;
+		}
+
+		Storage storage;
+		Location* handleTable;		// locations in storage, indexed by handle. (reserved VM)
+		size_t handleTableCapacity;	// committed entries of handleTable
+		Handle* freeHandles;		// released handles, capacity is same as handleTable
+		Handle numHandles;
+		size_t numFreeHandles;
+		size_t numAllocated;
+		uint32_t compactSource;		// chunk being compacted
+		uint32_t compactDestination;
+		Location* compactBuffer;
+		Lock lock;
+	};
+}
@@ -42,6 +42,7 @@
 *******************************************************************************/
 
 #include "DKMemory.h"
+#include "DKMalloc.h"
 
 namespace DKFoundation
 {
@@ -64,6 +65,40 @@ extern "C" void* DKMalloc(size_t s)
 	return DKMemoryPoolAlloc(s);
 }
 
+extern "C" void* DKCalloc(size_t n, size_t s)
+{
+	return DKMemoryPoolCalloc(n, s);
+}
+
+extern "C" void* DKMallocAligned(size_t s, size_t a)
+{
+	return DKMemoryPoolAlignedAlloc(s, a);
+}
+
+extern "C" void* DKMallocIsolated(size_t s)
+{
+	return DKMemoryPoolIsolatedAlloc(s);
+}
+
+extern "C" void* DKMallocHint(size_t s, int hint)
+{
+	switch (hint)
+	{
+	case DKMallocHintShortLived:
+		return DKMemoryPoolHintAlloc(s, DKMemoryLifetimeShort);
+	case DKMallocHintLongLived:
+		return DKMemoryPoolHintAlloc(s, DKMemoryLifetimeLong);
+	case DKMallocHintCold:
+		return DKMemoryPoolHintAlloc(s, DKMemoryLifetimeCold);
+	}
+	return DKMemoryPoolAlloc(s);
+}
+
+extern "C" void* DKMallocNear(void* hint, size_t s)
+{
+	return DKMemoryPoolAllocNear(hint, s);
+}
+
 extern "C" void* DKRealloc(void* p, size_t s)
 {
 	return DKMemoryPoolRealloc(p, s);
@@ -74,12 +109,133 @@ extern "C" void DKFree(void* p)
 	return DKMemoryPoolFree(p);
 }
 
+extern "C" void DKFreeSized(void* p, size_t s)
+{
+	return DKMemoryPoolFreeSized(p, s);
+}
+
+extern "C" void DKFreeAlignedSized(void* p, size_t s, size_t a)
+{
+	return DKMemoryPoolAlignedFreeSized(p, s, a);
+}
+
+extern "C" size_t DKMallocUsableSize(void* p)
+{
+	return DKMemoryPoolUsableSize(p);
+}
+
+extern "C" size_t DKMallocGoodSize(size_t s)
+{
+	return DKMemoryPoolGoodSize(s);
+}
+
+extern "C" int DKTryExpand(void* p, size_t s)
+{
+	return DKMemoryPoolTryExpand(p, s) ? 1 : 0;
+}
+
+extern "C" DKHeap* DKHeapCreate(void)
+{
+	return reinterpret_cast<DKHeap*>(DKPrivateHeapCreate());
+}
+
+extern "C" void DKHeapDestroy(DKHeap* heap)
+{
+	DKPrivateHeapDestroy(reinterpret_cast<DKPrivateHeap*>(heap));
+}
+
+extern "C" void* DKHeapAlloc(DKHeap* heap, size_t s)
+{
+	return DKPrivateHeapAlloc(reinterpret_cast<DKPrivateHeap*>(heap), s);
+}
+
+extern "C" void* DKHeapRealloc(DKHeap* heap, void* p, size_t s)
+{
+	return DKPrivateHeapRealloc(reinterpret_cast<DKPrivateHeap*>(heap), p, s);
+}
+
+extern "C" void DKHeapFree(DKHeap* heap, void* p)
+{
+	DKPrivateHeapFree(reinterpret_cast<DKPrivateHeap*>(heap), p);
+}
+
+extern "C" size_t DKHeapSize(DKHeap* heap)
+{
+	return DKPrivateHeapSize(reinterpret_cast<DKPrivateHeap*>(heap));
+}
+
+extern "C" DKPool* DKPoolCreate(size_t unitSize, size_t alignment, unsigned int flags)
+{
+	return reinterpret_cast<DKPool*>(DKFixedSizePoolCreate(unitSize, alignment, (flags & DKPoolNoLock) == 0));
+}
+
+extern "C" void DKPoolDestroy(DKPool* pool)
+{
+	DKFixedSizePoolDestroy(reinterpret_cast<DKFixedSizePool*>(pool));
+}
+
+extern "C" void* DKPoolAlloc(DKPool* pool)
+{
+	return DKFixedSizePoolAlloc(reinterpret_cast<DKFixedSizePool*>(pool));
+}
+
+extern "C" void DKPoolFree(DKPool* pool, void* p)
+{
+	DKFixedSizePoolFree(reinterpret_cast<DKFixedSizePool*>(pool), p);
+}
+
+extern "C" void DKPoolReserve(DKPool* pool, size_t n)
+{
+	DKFixedSizePoolReserve(reinterpret_cast<DKFixedSizePool*>(pool), n);
+}
+
+extern "C" size_t DKPoolPurge(DKPool* pool)
+{
+	return DKFixedSizePoolPurge(reinterpret_cast<DKFixedSizePool*>(pool));
+}
+
+extern "C" void DKPoolStats(DKPool* pool, DKPoolStatus* status)
+{
+	DKFixedSizePoolStatus st;
+	DKFixedSizePoolQueryStatus(reinterpret_cast<DKFixedSizePool*>(pool), &st);
+	status->unitSize = st.unitSize;
+	status->totalUnits = st.totalUnits;
+	status->usedUnits = st.usedUnits;
+	status->size = st.size;
+}
+
 extern "C" size_t DKMemPurge(void)
 {
 	return DKMemoryPoolPurge();
 }
 
+extern "C" void DKMemAdviseCold(void)
+{
+	DKMemoryPoolAdviseCold();
+}
+
 extern "C" size_t DKMemPoolSize(void)
 {
 	return DKMemoryPoolSize();
+}
+
+extern "C" void DKMemSetChunkPolicy(int policy)
+{
+	switch (policy)
+	{
+	case DKMemChunkPolicyMostOccupied:
+		DKMemoryPoolSetChunkPolicy(DKMemoryChunkPolicyMostOccupied);
+		break;
+	case DKMemChunkPolicyLowestAddress:
+		DKMemoryPoolSetChunkPolicy(DKMemoryChunkPolicyLowestAddress);
+		break;
+	default:
+		DKMemoryPoolSetChunkPolicy(DKMemoryChunkPolicyDefault);
+		break;
+	}
+}
+
+extern "C" int DKMallocCtl(const char* name, const size_t* in, size_t* out)
+{
+	return DKMemoryPoolControl(name, in, out);
 }
\ No newline at end of file
@@ -46,7 +46,9 @@
 
 /**
   DK allocator, allocate memory.
-  Returned memory address will be aligned with 16-bytes at least.
+  Returned memory address will be aligned with 16-bytes at least, except
+  requests smaller than 16 bytes when DKGL_MEMORY_POOL_TINY_UNIT_SIZE is set,
+  those are aligned with the tiny unit size (4 or 8) only.
 
   If the requested size is greater than 32k, DKMalloc uses the system VM to allocate space.
 */
@@ -56,13 +58,66 @@ extern "C"
 {
 #endif
 	void* DKMalloc(size_t size);
+	void* DKCalloc(size_t num, size_t size); /* zero-filled, NULL if num * size overflows */
+	void* DKMallocAligned(size_t size, size_t alignment); /* alignment must be power of two */
+	void* DKMallocIsolated(size_t size); /* cache line aligned, never shares a cache line with other allocations */
+	/* lifetime hint, each hint has its own chunks. release with DKFree (not DKFreeSized) */
+	enum { DKMallocHintNone = 0, DKMallocHintShortLived = 1, DKMallocHintLongLived = 2, DKMallocHintCold = 3 };
+	void* DKMallocHint(size_t size, int hint);
+	void* DKMallocNear(void* hint, size_t size); /* close to hint if hint has same size class, same chunk or page */
 	void* DKRealloc(void* ptr, size_t size);
 	void DKFree(void* ptr);
+	void DKFreeSized(void* ptr, size_t size); /* size must be the requested size, faster than DKFree */
+	void DKFreeAlignedSized(void* ptr, size_t size, size_t alignment); /* for DKMallocAligned */
+
+	/* actual usable size of ptr. (bucket unit size or VM region size) */
+	size_t DKMallocUsableSize(void* ptr);
+	/* allocation size that DKMalloc will round the request size up to */
+	size_t DKMallocGoodSize(size_t size);
+	/* expand ptr in place, returns non-zero if succeeded. ptr never moves */
+	int DKTryExpand(void* ptr, size_t size);
+
+	/* private heap without locking, must not be used by multiple threads at the same time */
+	typedef struct DKHeap DKHeap;
+	DKHeap* DKHeapCreate(void);
+	void DKHeapDestroy(DKHeap* heap); /* release all memory allocated from heap */
+	void* DKHeapAlloc(DKHeap* heap, size_t size);
+	void* DKHeapRealloc(DKHeap* heap, void* ptr, size_t size);
+	void DKHeapFree(DKHeap* heap, void* ptr);
+	size_t DKHeapSize(DKHeap* heap);
+
+	/* fixed-size pool, unit size and alignment (power of two) are given at runtime */
+	typedef struct DKPool DKPool;
+	typedef struct DKPoolStatus
+	{
+		size_t unitSize;	/* unit size including alignment padding */
+		size_t totalUnits;
+		size_t usedUnits;
+		size_t size;		/* pool size in bytes, including reserved space */
+	} DKPoolStatus;
+	enum { DKPoolNoLock = 1 };	/* flag: pool must not be used by multiple threads at the same time */
+	DKPool* DKPoolCreate(size_t unitSize, size_t alignment, unsigned int flags);
+	void DKPoolDestroy(DKPool* pool); /* release all units allocated from pool */
+	void* DKPoolAlloc(DKPool* pool);
+	void DKPoolFree(DKPool* pool, void* ptr);
+	void DKPoolReserve(DKPool* pool, size_t numUnits);
+	size_t DKPoolPurge(DKPool* pool);
+	void DKPoolStats(DKPool* pool, DKPoolStatus* status);
 
 	/* explicit cleanup. (useful to low-memory situation) */
 	size_t DKMemPurge(void);
+	void DKMemAdviseCold(void); /* pages of DKMallocHintCold chunks can be reclaimed (Linux only) */
 	size_t DKMemPoolSize(void); /* Allocated size, each allocation is less than 32KB */
 
+	/* chunk selection policy of pool buckets, see DKMemoryChunkPolicy */
+	enum { DKMemChunkPolicyDefault = 0, DKMemChunkPolicyMostOccupied = 1, DKMemChunkPolicyLowestAddress = 2 };
+	void DKMemSetChunkPolicy(int policy);
+
+	/* read (out) and write (in) tuning options by name, returns 0 or errno value.
+	   options can be set with environment variable DKMALLOC_CONF="name:value,name:value"
+	   see DKMemoryPoolControl for names */
+	int DKMallocCtl(const char* name, const size_t* in, size_t* out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,289 @@
+/*******************************************************************************
+ File: DKMallocConst.h
+ Author: Hongtae Kim (tiff2766@gmail.com)
+
+ Copyright (c) 2015,2017 Hongtae Kim. All rights reserved.
+
+ NOTE: This is simplified 'Memory Allocator' part of DKGL.
+ Full version of DKGL: https://github.com/DKGL/DKGL
+
+ License: BSD-3
+*******************************************************************************/
+/*******************************************************************************
+
+ Copyright (c) 2015, Hongtae Kim.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of DKMalloc nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*******************************************************************************/
+
+#pragma once
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "DKDef.h"
+#include "DKSpinLock.h"
+#include "DKMemory.h"
+#include "DKFixedSizeAllocator.h"
+
+// number of memory pool size classes for each power of two. (power of two)
+// classes are spaced 16 bytes at least, 16 makes about 110 classes.
+#ifndef DKGL_MEMORY_POOL_CLASSES_PER_DOUBLING
+#define DKGL_MEMORY_POOL_CLASSES_PER_DOUBLING 16
+#endif
+
+// smallest size class of memory pool, to serve tiny objects. (opt-in)
+// 8: 8 bytes class, 4: 4 and 8 bytes classes, 0: disabled. (16 bytes class)
+// tiny classes are aligned with their unit size, not with 16 bytes.
+#ifndef DKGL_MEMORY_POOL_TINY_UNIT_SIZE
+#define DKGL_MEMORY_POOL_TINY_UNIT_SIZE 0
+#endif
+
+// cache coloring of memory pool, 1: enabled, 0: disabled. (opt-in)
+// unit area of chunks and large blocks start at varying cache line offset,
+// within spare bytes which are otherwise wasted.
+#ifndef DKGL_MEMORY_CACHE_COLORING
+#define DKGL_MEMORY_CACHE_COLORING 0
+#endif
+
+namespace DKFoundation
+{
+	namespace Private
+	{
+		// PoolBucketSpacing : spacing policy of size classes.
+		//   each power of two range is divided into ClassesPerDoubling classes,
+		//   (16 bytes spacing at least) then each class is grown to the largest
+		//   size which has same units per chunk, to minimize tail waste of chunk.
+		//   tiny classes (smaller than MinUnitSize) are doubled up to MinUnitSize.
+		struct PoolBucketSpacing
+		{
+			enum : size_t { ClassesPerDoubling = DKGL_MEMORY_POOL_CLASSES_PER_DOUBLING };
+			enum : size_t { TinyUnitSize = DKGL_MEMORY_POOL_TINY_UNIT_SIZE };
+			enum : size_t { MinUnitSize = 16 };			// spacing and alignment of classes
+			enum : size_t { FirstUnitSize = (TinyUnitSize > 0) ? size_t(TinyUnitSize) : size_t(MinUnitSize) };
+			enum : size_t { MaxUnitSize = 32768 };
+			enum : size_t { MaxChunkSize = (1 << 18) };	// BackendAllocator::UnitSize
+			enum : size_t { MaxUnitsPerChunk = 0xffff };	// DKFixedSizeAllocator limit
+			static_assert(ClassesPerDoubling > 0 && (ClassesPerDoubling & (ClassesPerDoubling - 1)) == 0,
+						  "DKGL_MEMORY_POOL_CLASSES_PER_DOUBLING must be power of two.");
+			static_assert(TinyUnitSize == 0 || TinyUnitSize == 4 || TinyUnitSize == 8,
+						  "DKGL_MEMORY_POOL_TINY_UNIT_SIZE must be 0, 4 or 8.");
+
+			static constexpr size_t Log2(size_t n)		{ return n > 1 ? 1 + Log2(n >> 1) : 0; }
+			static constexpr size_t Spacing(size_t s)
+			{
+				return ((size_t(1) << Log2(s)) / ClassesPerDoubling) > MinUnitSize ?
+					((size_t(1) << Log2(s)) / ClassesPerDoubling) : size_t(MinUnitSize);
+			}
+			/// largest size which has same units per chunk with s.
+			static constexpr size_t Fit(size_t s)
+			{
+				return (MaxChunkSize / (MaxChunkSize / s)) & ~size_t(MinUnitSize - 1);
+			}
+			/// next class of unit size s.
+			static constexpr size_t Next(size_t s)
+			{
+				return s < MinUnitSize ? s * 2 :
+					Fit(s + Spacing(s)) < MaxUnitSize ? Fit(s + Spacing(s)) : size_t(MaxUnitSize);
+			}
+			static constexpr size_t Count(size_t s)
+			{
+				return s < MaxUnitSize ? 1 + Count(Next(s)) : 1;
+			}
+			static constexpr size_t IndexFrom(size_t s, size_t index, size_t unitSize)
+			{
+				return s <= unitSize ? index : IndexFrom(s, index + 1, Next(unitSize));
+			}
+		};
+
+		// PoolBucketClass : size classes of memory pool buckets. (FirstUnitSize ~ 32768)
+		//   classes are generated at compile time by PoolBucketSpacing.
+		struct PoolBucketClass : public PoolBucketSpacing
+		{
+			enum : size_t { NumBuckets = Count(FirstUnitSize) };
+
+			static constexpr size_t UnitSize(size_t index)
+			{
+				return index == 0 ? size_t(FirstUnitSize) : Next(UnitSize(index - 1));
+			}
+			static constexpr size_t NumUnits(size_t index)
+			{
+				return (MaxChunkSize / UnitSize(index)) < MaxUnitsPerChunk ?
+					(MaxChunkSize / UnitSize(index)) : size_t(MaxUnitsPerChunk);
+			}
+			/// smallest bucket which can hold s bytes. (s <= MaxUnitSize)
+			static constexpr size_t IndexForSize(size_t s)
+			{
+				return IndexFrom(s, 0, FirstUnitSize);
+			}
+		};
+		static_assert(PoolBucketClass::UnitSize(PoolBucketClass::NumBuckets - 1) == PoolBucketClass::MaxUnitSize, "Wrong size class!");
+		static_assert(PoolBucketClass::NumBuckets < 0x7fff, "Too many size classes!");	// BackendAllocator::Index
+
+		// default purge thresholds of memory pool and private heaps.
+		//   free units kept by bucket, empty slots kept by backend.
+		enum : size_t { DefaultBucketPurgeThreshold = 0 };
+		enum : size_t { DefaultBackendPurgeThreshold = 16 };
+
+		// implemented in DKMemory.cpp
+		DKGL_API void* PoolBucketInstance(size_t index);
+		DKGL_API void* PoolBucketChunkAlloc(size_t index, size_t size, bool* zeroFilled);
+		DKGL_API void  PoolBucketChunkFree(size_t index, void* p);
+		DKGL_API void  PoolBucketChunkPurged(void);
+		DKGL_API void* PoolBucketMetadataAlloc(size_t);
+		DKGL_API void* PoolBucketMetadataRealloc(void*, size_t);
+		DKGL_API void  PoolBucketMetadataFree(void*);
+
+		// PoolBucketChunkAllocator : allocates chunks for memory pool buckets.
+		//   This is wrapper of BackendAllocator and keep track address that
+		//   was allocated by BackendAllocator.
+		struct PoolBucketChunkAllocator
+		{
+			size_t index;
+
+			void* Alloc(size_t s)					{ return PoolBucketChunkAlloc(index, s, NULL); }
+			void* Alloc(size_t s, bool* zeroFilled)	{ return PoolBucketChunkAlloc(index, s, zeroFilled); }
+			void Free(void* p)						{ PoolBucketChunkFree(index, p); }
+		};
+		// PoolBucketMetadataAllocator : allocates chunk table of buckets.
+		struct PoolBucketMetadataAllocator
+		{
+			static void* Alloc(size_t s)			{ return PoolBucketMetadataAlloc(s); }
+			static void* Realloc(void* p, size_t s)	{ return PoolBucketMetadataRealloc(p, s); }
+			static void Free(void* p)				{ PoolBucketMetadataFree(p); }
+		};
+
+		/// bucket allocator aligned with cache line, unit size is given at runtime.
+		/// buckets used by different threads never share a cache line.
+		template <typename Lock, typename BaseAllocator, typename UnitAllocator>
+		struct alignas(DKGL_CACHE_LINE_SIZE) PoolBucketAllocatorT
+			: public DKFixedSizeAllocator<0, 1, PoolBucketClass::NumUnits(0), Lock, BaseAllocator, UnitAllocator>
+		{
+			using Base = DKFixedSizeAllocator<0, 1, PoolBucketClass::NumUnits(0), Lock, BaseAllocator, UnitAllocator>;
+			using Base::Base;
+		};
+		/// allocator type of memory pool buckets.
+		/// all buckets share one type, stored inline in AllocatorPool.
+		using PoolBucketAllocator = PoolBucketAllocatorT<DKSpinLock, PoolBucketMetadataAllocator, PoolBucketChunkAllocator>;
+
+		template <size_t Index> FORCEINLINE PoolBucketAllocator* PoolBucket(void)
+		{
+			static PoolBucketAllocator* const bucket =
+				reinterpret_cast<PoolBucketAllocator*>(PoolBucketInstance(Index));
+			return bucket;
+		}
+
+		template <size_t N> FORCEINLINE void* PoolAllocConst(std::true_type)
+		{
+			return PoolBucket<PoolBucketClass::IndexForSize(N)>()->Alloc(N);
+		}
+		template <size_t N> FORCEINLINE void* PoolAllocConst(std::false_type)
+		{
+			return DKMemoryPoolAlloc(N);
+		}
+		template <size_t N> FORCEINLINE void PoolFreeConst(void* p, std::true_type)
+		{
+			size_t purged = 0;
+			if (PoolBucket<PoolBucketClass::IndexForSize(N)>()->ConditionalDeallocAndPurge(p, DefaultBucketPurgeThreshold, &purged))
+			{
+				if (purged > 0)
+					PoolBucketChunkPurged();
+				return;
+			}
+			DKASSERT_MEM_DESC_DEBUG(0, "Invalid size!");
+			DKMemoryPoolFree(p);
+		}
+		template <size_t N> FORCEINLINE void PoolFreeConst(void* p, std::false_type)
+		{
+			DKMemoryPoolFree(p);
+		}
+
+		// types aligned greater than 16 bytes use aligned path.
+		template <typename T> FORCEINLINE void* PoolAllocType(std::false_type)
+		{
+			return PoolAllocConst<sizeof(T)>(std::integral_constant<bool, (sizeof(T) <= PoolBucketClass::MaxUnitSize)>());
+		}
+		template <typename T> FORCEINLINE void* PoolAllocType(std::true_type)
+		{
+			return DKMemoryPoolAlignedAlloc(sizeof(T), alignof(T));
+		}
+		template <typename T> FORCEINLINE void PoolFreeType(void* p, std::false_type)
+		{
+			PoolFreeConst<sizeof(T)>(p, std::integral_constant<bool, (sizeof(T) <= PoolBucketClass::MaxUnitSize)>());
+		}
+		template <typename T> FORCEINLINE void PoolFreeType(void* p, std::true_type)
+		{
+			DKMemoryPoolAlignedFreeSized(p, sizeof(T), alignof(T));
+		}
+	}
+
+	/// allocate N bytes from memory pool, bucket is resolved at compile time.
+	/// memory can be released with DKFreeConst<N> or DKMemoryPoolFree.
+	/// @note
+	///   runtime options are not applied, N up to 32768 is always from bucket
+	///   even if large.cutoff is lower, and free keeps default purge threshold.
+	template <size_t N> FORCEINLINE void* DKMallocConst(void)
+	{
+		return Private::PoolAllocConst<N>(std::integral_constant<bool, (N <= Private::PoolBucketClass::MaxUnitSize)>());
+	}
+
+	/// release memory allocated by DKMallocConst<N>, N must be same.
+	template <size_t N> FORCEINLINE void DKFreeConst(void* p)
+	{
+		if (p)
+			Private::PoolFreeConst<N>(p, std::integral_constant<bool, (N <= Private::PoolBucketClass::MaxUnitSize)>());
+	}
+
+	/// create object of T in memory pool, returns NULL if out of memory.
+	template <typename T, typename... Args> T* DKPoolNew(Args&&... args)
+	{
+		void* p = Private::PoolAllocType<T>(std::integral_constant<bool, (alignof(T) > 16)>());
+		if (p)
+		{
+			try
+			{
+				return ::new (p) T(std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				Private::PoolFreeType<T>(p, std::integral_constant<bool, (alignof(T) > 16)>());
+				throw;
+			}
+		}
+		return NULL;
+	}
+
+	/// destroy object created by DKPoolNew<T>.
+	template <typename T> void DKPoolDelete(T* p)
+	{
+		if (p)
+		{
+			p->~T();
+			Private::PoolFreeType<T>(p, std::integral_constant<bool, (alignof(T) > 16)>());
+		}
+	}
+}
@@ -0,0 +1,149 @@
+/*******************************************************************************
+ File: DKMallocNew.h
+ Author: Hongtae Kim (tiff2766@gmail.com)
+
+ Copyright (c) 2015,2017 Hongtae Kim. All rights reserved.
+
+ NOTE: This is simplified 'Memory Allocator' part of DKGL.
+ Full version of DKGL: https://github.com/DKGL/DKGL
+
+ License: BSD-3
+*******************************************************************************/
+/*******************************************************************************
+
+ Copyright (c) 2015, Hongtae Kim.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of DKMalloc nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*******************************************************************************/
+
+#pragma once
+#include <new>
+#include "DKMemory.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// DKMallocNew.h
+// replaces global operator new, delete with memory pool.
+//
+// Include this file in exactly one source file of your program.
+// (replacement operators cannot be inline)
+//
+//   #include "DKMalloc/DKMallocNew.h"
+//
+// Sized delete (C++14) selects bucket by size without address lookup,
+// aligned new (C++17) allocates with requested alignment.
+//
+// Define DKGL_OPERATOR_NEW_ALLOC, DKGL_OPERATOR_NEW_ALIGNED_ALLOC,
+// DKGL_OPERATOR_DELETE, DKGL_OPERATOR_DELETE_SIZED and
+// DKGL_OPERATOR_DELETE_ALIGNED_SIZED before including this file to
+// use other allocation functions. (see DKMallocPreload.cpp)
+// The default operator new never returns a tiny size class block, those are
+// only aligned to DKGL_MEMORY_POOL_TINY_UNIT_SIZE, and new must give 16.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef DKGL_OPERATOR_NEW_ALLOC
+#define DKGL_OPERATOR_NEW_ALLOC(s)							DKFoundation::DKMemoryPoolAlloc(DKFoundation::Max(s, size_t(16)))
+#endif
+#ifndef DKGL_OPERATOR_NEW_ALIGNED_ALLOC
+#define DKGL_OPERATOR_NEW_ALIGNED_ALLOC(s, a)				DKFoundation::DKMemoryPoolAlignedAlloc(s, a)
+#endif
+#ifndef DKGL_OPERATOR_DELETE
+#define DKGL_OPERATOR_DELETE(p)								DKFoundation::DKMemoryPoolFree(p)
+#endif
+#ifndef DKGL_OPERATOR_DELETE_SIZED
+#define DKGL_OPERATOR_DELETE_SIZED(p, s)					DKFoundation::DKMemoryPoolFreeSized(p, DKFoundation::Max(s, size_t(16)))
+#endif
+#ifndef DKGL_OPERATOR_DELETE_ALIGNED_SIZED
+#define DKGL_OPERATOR_DELETE_ALIGNED_SIZED(p, s, a)			DKFoundation::DKMemoryPoolAlignedFreeSized(p, s, a)
+#endif
+
+namespace DKFoundation
+{
+	namespace Private
+	{
+		namespace
+		{
+			NOINLINE void* OperatorNew(size_t s, size_t alignment, bool nothrow)
+			{
+				while (true)
+				{
+					void* p = (alignment > 16) ? DKGL_OPERATOR_NEW_ALIGNED_ALLOC(s, alignment) : DKGL_OPERATOR_NEW_ALLOC(s);
+					if (p)
+						return p;
+					std::new_handler handler = std::get_new_handler();
+					if (handler == NULL)
+					{
+						if (nothrow)
+							return NULL;
+						throw std::bad_alloc();
+					}
+					if (nothrow)
+					{
+						try { handler(); }
+						catch (...) { return NULL; }
+					}
+					else
+					{
+						handler();
+					}
+				}
+			}
+			FORCEINLINE void* OperatorNew(size_t s)
+			{
+				void* p = DKGL_OPERATOR_NEW_ALLOC(s);
+				if (p)
+					return p;
+				return OperatorNew(s, 0, false);
+			}
+		}
+	}
+}
+
+void* operator new (size_t s)										{ return DKFoundation::Private::OperatorNew(s); }
+void* operator new[] (size_t s)										{ return DKFoundation::Private::OperatorNew(s); }
+void* operator new (size_t s, const std::nothrow_t&) noexcept		{ return DKFoundation::Private::OperatorNew(s, 0, true); }
+void* operator new[] (size_t s, const std::nothrow_t&) noexcept		{ return DKFoundation::Private::OperatorNew(s, 0, true); }
+void operator delete (void* p) noexcept								{ DKGL_OPERATOR_DELETE(p); }
+void operator delete[] (void* p) noexcept							{ DKGL_OPERATOR_DELETE(p); }
+void operator delete (void* p, const std::nothrow_t&) noexcept		{ DKGL_OPERATOR_DELETE(p); }
+void operator delete[] (void* p, const std::nothrow_t&) noexcept	{ DKGL_OPERATOR_DELETE(p); }
+#ifdef __cpp_sized_deallocation
+void operator delete (void* p, size_t s) noexcept					{ DKGL_OPERATOR_DELETE_SIZED(p, s); }
+void operator delete[] (void* p, size_t s) noexcept					{ DKGL_OPERATOR_DELETE_SIZED(p, s); }
+#endif
+#ifdef __cpp_aligned_new
+void* operator new (size_t s, std::align_val_t a)										{ return DKFoundation::Private::OperatorNew(s, static_cast<size_t>(a), false); }
+void* operator new[] (size_t s, std::align_val_t a)										{ return DKFoundation::Private::OperatorNew(s, static_cast<size_t>(a), false); }
+void* operator new (size_t s, std::align_val_t a, const std::nothrow_t&) noexcept		{ return DKFoundation::Private::OperatorNew(s, static_cast<size_t>(a), true); }
+void* operator new[] (size_t s, std::align_val_t a, const std::nothrow_t&) noexcept		{ return DKFoundation::Private::OperatorNew(s, static_cast<size_t>(a), true); }
+void operator delete (void* p, std::align_val_t) noexcept								{ DKGL_OPERATOR_DELETE(p); }
+void operator delete[] (void* p, std::align_val_t) noexcept								{ DKGL_OPERATOR_DELETE(p); }
+void operator delete (void* p, std::align_val_t, const std::nothrow_t&) noexcept		{ DKGL_OPERATOR_DELETE(p); }
+void operator delete[] (void* p, std::align_val_t, const std::nothrow_t&) noexcept		{ DKGL_OPERATOR_DELETE(p); }
+void operator delete (void* p, size_t s, std::align_val_t a) noexcept					{ DKGL_OPERATOR_DELETE_ALIGNED_SIZED(p, s, static_cast<size_t>(a)); }
+void operator delete[] (void* p, size_t s, std::align_val_t a) noexcept					{ DKGL_OPERATOR_DELETE_ALIGNED_SIZED(p, s, static_cast<size_t>(a)); }
+#endif
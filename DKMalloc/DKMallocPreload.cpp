@@ -0,0 +1,329 @@
+/*******************************************************************************
+ File: DKMallocPreload.cpp
+ Author: Hongtae Kim (tiff2766@gmail.com)
+
+ Copyright (c) 2015,2017 Hongtae Kim. All rights reserved.
+
+ NOTE: This is simplified 'Memory Allocator' part of DKGL.
+ Full version of DKGL: https://github.com/DKGL/DKGL
+
+ License: BSD-3
+*******************************************************************************/
+/*******************************************************************************
+
+ Copyright (c) 2015, Hongtae Kim.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of DKMalloc nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*******************************************************************************/
+
+////////////////////////////////////////////////////////////////////////////////
+// DKMallocPreload
+// replaces system malloc with DKMalloc. (Linux, glibc)
+//
+// Build as shared library with DKGL_MALLOC_PRELOAD defined, and run
+// unmodified programs with LD_PRELOAD.
+//
+//   g++ -std=c++11 -O2 -fPIC -shared -DDKGL_MALLOC_PRELOAD -o libdkmalloc.so DKMalloc/*.cpp
+//   LD_PRELOAD=./libdkmalloc.so <program>
+//
+// The memory pool allocates its own metadata from VM directly, but other
+// allocations made while the memory pool is being initialized (from C++
+// runtime, other threads) are served from a static bootstrap heap, and they
+// are never released.
+// The memory pool is never destroyed, it must be available until the
+// process terminates. (even after atexit() called)
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(DKGL_MALLOC_PRELOAD) && defined(__linux__)
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef __GLIBC__	// defined by libc headers
+#error "DKGL_MALLOC_PRELOAD requires glibc."
+#endif
+#include <new>
+#include "DKMemory.h"
+#include "DKAllocatorChain.h"
+
+#define DKGL_MALLOC_EXPORT	extern "C" __attribute__((visibility("default")))
+
+namespace DKFoundation
+{
+	namespace Private
+	{
+		namespace
+		{
+			// BootstrapHeap : serves allocations until memory pool is ready.
+			struct BootstrapHeap
+			{
+				enum { Size = (1 << 18) }; // 256 KB
+				enum { HeaderSize = 16 };
+
+				static void* Alloc(size_t s)
+				{
+					size_t blockSize = HeaderSize + ((s + 15) & ~size_t(15));
+					if (blockSize < s)
+						return NULL;
+					size_t offset = __sync_fetch_and_add(&used, blockSize);
+					if (offset + blockSize > Size)
+						return NULL;	// out of memory!
+					uint8_t* p = &heap[offset];
+					*reinterpret_cast<size_t*>(p) = s;
+					return p + HeaderSize;
+				}
+				static bool Contains(void* p)
+				{
+					uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+					uintptr_t begin = reinterpret_cast<uintptr_t>(&heap[0]);
+					return addr >= begin && addr < begin + Size;
+				}
+				static size_t UsableSize(void* p)
+				{
+					return *reinterpret_cast<size_t*>(reinterpret_cast<uint8_t*>(p) - HeaderSize);
+				}
+
+				alignas(16) static uint8_t heap[Size];
+				static size_t used;
+			};
+			alignas(16) uint8_t BootstrapHeap::heap[BootstrapHeap::Size];
+			size_t BootstrapHeap::used = 0;
+
+			enum PoolState
+			{
+				PoolStateUninitialized = 0,
+				PoolStateInitializing,
+				PoolStateReady,
+			};
+			volatile int poolState = PoolStateUninitialized;
+
+			NOINLINE bool InitializePool(void)
+			{
+				if (__sync_bool_compare_and_swap(&poolState, PoolStateUninitialized, PoolStateInitializing))
+				{
+					// extend allocator life cycle until process terminated.
+					alignas(DKAllocatorChain::Maintainer) static uint8_t storage[sizeof(DKAllocatorChain::Maintainer)];
+					::new (storage) DKAllocatorChain::Maintainer();
+
+					DKMemoryPoolSize();	// create memory pool.
+					__sync_synchronize();
+					poolState = PoolStateReady;
+					return true;
+				}
+				// recursive call or other thread is initializing.
+				return poolState == PoolStateReady;
+			}
+
+			FORCEINLINE bool IsPoolReady(void)
+			{
+				if (poolState == PoolStateReady)
+					return true;
+				return InitializePool();
+			}
+
+			// glibc malloc is 16 bytes aligned (max_align_t), tiny size classes
+			// are not. keep every unaligned request out of them.
+			FORCEINLINE size_t MallocSize(size_t s)
+			{
+				return Max(s, size_t(16));
+			}
+
+			FORCEINLINE void* Alloc(size_t s)
+			{
+				void* p = IsPoolReady() ? DKMemoryPoolAlloc(MallocSize(s)) : BootstrapHeap::Alloc(s);
+				if (p == NULL)
+					errno = ENOMEM;
+				return p;
+			}
+
+			FORCEINLINE void* AlignedAlloc(size_t s, size_t alignment)
+			{
+				void* p = NULL;
+				if (IsPoolReady())
+					p = DKMemoryPoolAlignedAlloc(s, alignment);
+				else if (alignment <= 16)
+					p = BootstrapHeap::Alloc(s);
+				if (p == NULL)
+					errno = ENOMEM;
+				return p;
+			}
+
+			FORCEINLINE void Free(void* p)
+			{
+				if (p && !BootstrapHeap::Contains(p))
+					DKMemoryPoolFree(p);
+			}
+
+			FORCEINLINE void* Realloc(void* p, size_t s)
+			{
+				if (p && BootstrapHeap::Contains(p))
+				{
+					void* p2 = Alloc(s);
+					if (p2)
+						memcpy(p2, p, Min(s, BootstrapHeap::UsableSize(p)));
+					return p2;
+				}
+				if (IsPoolReady())
+				{
+					void* p2 = DKMemoryPoolRealloc(p, s > 0 ? MallocSize(s) : 0);
+					if (p2 == NULL && s > 0)
+						errno = ENOMEM;
+					return p2;
+				}
+				// pool is not ready. p is NULL.
+				return Alloc(s);
+			}
+		}
+	}
+}
+
+using namespace DKFoundation;
+using namespace DKFoundation::Private;
+
+DKGL_MALLOC_EXPORT void* malloc(size_t s)
+{
+	return Alloc(s);
+}
+
+DKGL_MALLOC_EXPORT void free(void* p)
+{
+	Free(p);
+}
+
+DKGL_MALLOC_EXPORT void* realloc(void* p, size_t s)
+{
+	return Realloc(p, s);
+}
+
+DKGL_MALLOC_EXPORT void* calloc(size_t n, size_t s)
+{
+	if (IsPoolReady())
+	{
+		if (n < 16 && s < 16 && n * s < 16)
+		{
+			n = 1;
+			s = 16;
+		}
+		void* p = DKMemoryPoolCalloc(n, s);
+		if (p == NULL)
+			errno = ENOMEM;
+		return p;
+	}
+	size_t size = n * s;
+	if (s > 0 && size / s != n)
+	{
+		errno = ENOMEM;
+		return NULL;
+	}
+	return BootstrapHeap::Alloc(size);	// bootstrap heap is zero-filled.
+}
+
+DKGL_MALLOC_EXPORT int posix_memalign(void** p, size_t alignment, size_t s)
+{
+	if (alignment < sizeof(void*) || (alignment & (alignment - 1)))
+		return EINVAL;
+	void* ptr = AlignedAlloc(s, alignment);
+	if (ptr == NULL)
+		return ENOMEM;
+	*p = ptr;
+	return 0;
+}
+
+DKGL_MALLOC_EXPORT void* aligned_alloc(size_t alignment, size_t s)
+{
+	if (alignment & (alignment - 1))
+	{
+		errno = EINVAL;
+		return NULL;
+	}
+	return AlignedAlloc(s, alignment);
+}
+
+DKGL_MALLOC_EXPORT void* memalign(size_t alignment, size_t s)
+{
+	return aligned_alloc(alignment, s);
+}
+
+DKGL_MALLOC_EXPORT void* valloc(size_t s)
+{
+	return AlignedAlloc(s, DKMemoryPageSize());
+}
+
+DKGL_MALLOC_EXPORT void* pvalloc(size_t s)
+{
+	size_t pageSize = DKMemoryPageSize();
+	size_t alignedSize = (s + pageSize - 1) & ~(pageSize - 1);
+	if (alignedSize < s)
+	{
+		errno = ENOMEM;
+		return NULL;
+	}
+	return AlignedAlloc(alignedSize, pageSize);
+}
+
+DKGL_MALLOC_EXPORT size_t malloc_usable_size(void* p)
+{
+	if (p == NULL)
+		return 0;
+	if (BootstrapHeap::Contains(p))
+		return BootstrapHeap::UsableSize(p);
+	return DKMemoryPoolUsableSize(p);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// C++ operator new, delete
+////////////////////////////////////////////////////////////////////////////////
+namespace DKFoundation
+{
+	namespace Private
+	{
+		namespace
+		{
+			FORCEINLINE void FreeSized(void* p, size_t s)
+			{
+				if (p && !BootstrapHeap::Contains(p))
+					DKMemoryPoolFreeSized(p, MallocSize(s));
+			}
+			FORCEINLINE void AlignedFreeSized(void* p, size_t s, size_t alignment)
+			{
+				if (p && !BootstrapHeap::Contains(p))
+					DKMemoryPoolAlignedFreeSized(p, s, alignment);
+			}
+		}
+	}
+}
+
+#define DKGL_OPERATOR_NEW_ALLOC(s)							Alloc(s)
+#define DKGL_OPERATOR_NEW_ALIGNED_ALLOC(s, a)				AlignedAlloc(s, a)
+#define DKGL_OPERATOR_DELETE(p)								Free(p)
+#define DKGL_OPERATOR_DELETE_SIZED(p, s)					FreeSized(p, s)
+#define DKGL_OPERATOR_DELETE_ALIGNED_SIZED(p, s, a)			AlignedFreeSized(p, s, a)
+#include "DKMallocNew.h"
+
+#endif /* defined(DKGL_MALLOC_PRELOAD) && defined(__linux__) */
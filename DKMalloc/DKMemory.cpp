@@ -59,9 +59,18 @@
 #include <errno.h>
 #include <fcntl.h>
 #endif
+#include <errno.h>
+#include <stdlib.h>
+#include <atomic>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DKGL_SSE2_ENABLED 1
+#endif
 
 #include "DKMemory.h"
 #include "DKFixedSizeAllocator.h"
+#include "DKMallocConst.h"
 
 
 
@@ -71,22 +80,19 @@ namespace DKFoundation
 	{
 		static DKAllocator::Maintainer maintainer;
 
-		struct SystemHeapAllocator
+		// MetadataAllocator : allocates internal tables and objects of memory pool.
+		//   Memory is reserved and committed from system VM directly, it does
+		//   not depend on system heap (malloc), so that memory pool can be used
+		//   as system heap. (see DKMallocPreload.cpp)
+		//   Small blocks are never returned to system, they are recycled.
+		struct MetadataAllocator
 		{
-#ifdef _WIN32
-			static HANDLE heap;
-#endif
 			FORCEINLINE static void* Alloc(size_t s)
 			{
-#ifdef _WIN32
-				return ::HeapAlloc(heap, 0, s);
-#else
-				return ::malloc(s);
-#endif
+				return Instance().AllocBlock(s);
 			}
 			FORCEINLINE static void* Realloc(void* p, size_t s)
 			{
-#ifdef _WIN32
 				if (p == NULL)
 					return Alloc(s);
 				if (s == 0)
@@ -94,375 +100,775 @@ namespace DKFoundation
 					Free(p);
 					return NULL;
 				}
-				return ::HeapReAlloc(heap, 0, p, s);
-#else
-				return ::realloc(p, s);
-#endif
+				size_t blockSize = BlockSize(p);
+				if (s + HeaderSize <= blockSize)
+					return p;
+				void* p2 = Alloc(s);
+				if (p2)
+				{
+					memcpy(p2, p, blockSize - HeaderSize);
+					Free(p);
+				}
+				return p2;
 			}
 			FORCEINLINE static void Free(void* p)
 			{
-#ifdef _WIN32
-				::HeapFree(heap, 0, p);
+				if (p)
+					Instance().FreeBlock(p);
+			}
+
+		private:
+			enum { HeaderSize = 16 };
+			enum { MinBlockSizeShift = 5, MaxBlockSizeShift = 15 };	// 32 B ~ 32 KB
+			enum { NumClasses = MaxBlockSizeShift - MinBlockSizeShift + 1 };
+			enum { LargeBlock = NumClasses };
+			enum { ArenaReserveSize = (1 << 26) };	// 64 MB
+			enum { ArenaCommitSize = (1 << 16) };	// 64 KB
+
+			struct Header
+			{
+				size_t size;		// block size, including header.
+				size_t classIndex;
+			};
+			static_assert(sizeof(Header) <= HeaderSize, "Invalid header size");
+			struct FreeNode
+			{
+				FreeNode* next;
+			};
+
+			static MetadataAllocator& Instance(void)
+			{
+				static MetadataAllocator allocator;
+				return allocator;
+			}
+			FORCEINLINE static Header* BlockHeader(void* p)
+			{
+				return reinterpret_cast<Header*>(reinterpret_cast<uint8_t*>(p) - HeaderSize);
+			}
+			FORCEINLINE static size_t BlockSize(void* p)
+			{
+				return BlockHeader(p)->size;
+			}
+
+			void* AllocBlock(size_t s)
+			{
+				size_t blockSize = s + HeaderSize;
+				if (blockSize < s)
+					return NULL; // overflow
+
+				if (blockSize > (size_t(1) << MaxBlockSizeShift))
+				{
+					// large block, allocate pages.
+					size_t pageSize = DKMemoryPageSize();
+					if (blockSize % pageSize)
+						blockSize += pageSize - (blockSize % pageSize);
+					void* p = DKMemoryPageReserve(NULL, blockSize);
+					if (p == NULL)
+						return NULL;
+					DKMemoryPageCommit(p, blockSize);
+					Header* header = reinterpret_cast<Header*>(p);
+					header->size = blockSize;
+					header->classIndex = LargeBlock;
+					return reinterpret_cast<uint8_t*>(p) + HeaderSize;
+				}
+
+				size_t classIndex = 0;
+				while ((size_t(1) << (classIndex + MinBlockSizeShift)) < blockSize)
+					classIndex++;
+				blockSize = size_t(1) << (classIndex + MinBlockSizeShift);
+
+				ScopedLock guard(lock);
+				uint8_t* block = reinterpret_cast<uint8_t*>(freeBlocks[classIndex]);
+				if (block)
+				{
+					freeBlocks[classIndex] = freeBlocks[classIndex]->next;
+				}
+				else
+				{
+					if (arenaPos + blockSize > arenaEnd)
+					{
+						// reserve new arena, remaining space of previous arena is discarded.
+						void* arena = DKMemoryPageReserve(NULL, ArenaReserveSize);
+						if (arena == NULL)
+							return NULL;
+						arenaPos = reinterpret_cast<uintptr_t>(arena);
+						arenaCommitted = arenaPos;
+						arenaEnd = arenaPos + ArenaReserveSize;
+					}
+					if (arenaPos + blockSize > arenaCommitted)
+					{
+						size_t commitSize = ArenaCommitSize;
+						while (arenaPos + blockSize > arenaCommitted + commitSize)
+							commitSize += ArenaCommitSize;
+						commitSize = Min(commitSize, size_t(arenaEnd - arenaCommitted));
+						DKMemoryPageCommit(reinterpret_cast<void*>(arenaCommitted), commitSize);
+						arenaCommitted += commitSize;
+					}
+					block = reinterpret_cast<uint8_t*>(arenaPos);
+					arenaPos += blockSize;
+				}
+				Header* header = reinterpret_cast<Header*>(block);
+				header->size = blockSize;
+				header->classIndex = classIndex;
+				return block + HeaderSize;
+			}
+			void FreeBlock(void* p)
+			{
+				Header* header = BlockHeader(p);
+				if (header->classIndex == LargeBlock)
+				{
+					DKMemoryPageRelease(header);
+					return;
+				}
+				DKASSERT_MEM_DEBUG(header->classIndex < NumClasses);
+				size_t classIndex = header->classIndex;
+				FreeNode* block = reinterpret_cast<FreeNode*>(header);
+
+				ScopedLock guard(lock);
+				block->next = freeBlocks[classIndex];
+				freeBlocks[classIndex] = block;
+			}
+
+			using ScopedLock = DKCriticalSection<DKSpinLock>;
+			DKSpinLock lock;
+			FreeNode* freeBlocks[NumClasses] = {};
+			uintptr_t arenaPos = 0;
+			uintptr_t arenaCommitted = 0;
+			uintptr_t arenaEnd = 0;
+		};
+
+		// used by DKAllocatorChain
+		void* MetadataAlloc(size_t s)
+		{
+			return MetadataAllocator::Alloc(s);
+		}
+		void MetadataFree(void* p)
+		{
+			MetadataAllocator::Free(p);
+		}
+
+		// expand VM region allocated by DKMemoryVirtualAlloc without moving.
+		static bool VirtualTryExpand(void* p, size_t s);
+		// allocate VM region aligned with given alignment. (greater than page size)
+		static void* VirtualAlignedAlloc(size_t s, size_t alignment);
+
+		// SystemLargeHeapAllocator : allocates large blocks with VM pages.
+		//   block can be colored, it starts at cache line offset within
+		//   spare bytes of last page. offset is less than page size,
+		//   VM region of block is found by page alignment.
+		struct SystemLargeHeapAllocator
+		{
+			enum { MaxColorRange = 4096 };
+
+			static void* Alloc(size_t s)
+			{
+#if DKGL_MEMORY_CACHE_COLORING
+				size_t pageSize = DKMemoryPageSize();
+				uintptr_t p = reinterpret_cast<uintptr_t>(DKMemoryVirtualAlloc(s));
+				size_t spare = (pageSize - (s % pageSize)) % pageSize;
+				if (p && spare >= DKGL_CACHE_LINE_SIZE)
+				{
+					size_t numColors = Min(spare, size_t(MaxColorRange)) / DKGL_CACHE_LINE_SIZE + 1;
+					p += ((p / pageSize) % numColors) * DKGL_CACHE_LINE_SIZE;
+				}
+				return reinterpret_cast<void*>(p);
 #else
-				return ::free(p);
+				return DKMemoryVirtualAlloc(s);
 #endif
 			}
+			// page aligned block, for aligned allocation.
+			static void* AlignedAlloc(size_t s)
+			{
+				return DKMemoryVirtualAlloc(s);
+			}
+			static void* Realloc(void* p, size_t s)
+			{
+				size_t offset = ColorOffset(p);
+				uint8_t* p2 = reinterpret_cast<uint8_t*>(DKMemoryVirtualRealloc(Base(p), s + offset));
+				return p2 ? p2 + offset : NULL;
+			}
+			static void Free(void* p)
+			{
+				DKMemoryVirtualFree(Base(p));
+			}
+			static size_t Size(void* p)
+			{
+				return DKMemoryVirtualSize(Base(p)) - ColorOffset(p);
+			}
+			static bool TryExpand(void* p, size_t s)
+			{
+				return VirtualTryExpand(Base(p), s + ColorOffset(p));
+			}
+		private:
+			FORCEINLINE static size_t ColorOffset(void* p)
+			{
+				return reinterpret_cast<uintptr_t>(p) % DKMemoryPageSize();
+			}
+			FORCEINLINE static void* Base(void* p)
+			{
+				return reinterpret_cast<uint8_t*>(p) - ColorOffset(p);
+			}
 		};
-#ifdef _WIN32
-		HANDLE SystemHeapAllocator::heap;
-#endif
-
-		using SystemLargeHeapAllocator = DKMemoryVirtualAllocator;
 
 		// BackendAllocator : allocates all front-end allocators chunks.
-		struct BackendAllocator
+		//   chunk size is power of two, from MinUnitSize (16KB) to UnitSize (256KB).
+		//   a slot (256KB) is split into chunks of same size, slots are allocated
+		//   from regions (16MB) which are aligned with region size.
+		//   region of address is found with two-level region table, and each
+		//   region has bucket index of granules (MinUnitSize), so that bucket
+		//   index of address can be found in constant time.
+		template <typename Lock> struct BackendAllocatorT
 		{
-			enum { UnitSize = (1 << 18) }; // 256 KB
-			enum { IndexTableAlignment = 64 };
-			static_assert((IndexTableAlignment & (IndexTableAlignment-1)) == 0, "Alignment should be power of two.");
-			using Allocator = DKFixedSizeAllocator<UnitSize, 1, 64, DKDummyLock, SystemHeapAllocator, SystemLargeHeapAllocator>;
-
-			static BackendAllocator* Instance();	// init by main allocator. (AllocatorPool)
+			enum { UnitSizeShift = 18 };
+			enum { UnitSize = (1 << UnitSizeShift) };	// 256 KB, largest chunk (slot)
+			enum { MinUnitSizeShift = 14 };
+			enum { MinUnitSize = (1 << MinUnitSizeShift) };	// 16 KB, smallest chunk
+			enum { NumUnitClasses = UnitSizeShift - MinUnitSizeShift + 1 };	// 16KB, 32KB, ... 256KB
+			enum { RegionShift = 24 };
+			enum { RegionSize = (1 << RegionShift) };	// 16 MB
+			enum { SlotsPerRegion = RegionSize / UnitSize };
+			enum { GranulesPerRegion = RegionSize / MinUnitSize };
+			static_assert((UnitSize / MinUnitSize) <= 16, "Slot bitmask must be 16 bits or less.");
+
+			// region table covers 48 bits address space on 64-bit platform.
+			enum { AddressBits = sizeof(void*) > 4 ? 48 : 32 };
+			enum { RegionBits = AddressBits - RegionShift };
+			enum { LeafBits = RegionBits > 12 ? 12 : RegionBits };
+			enum { RootBits = RegionBits - LeafBits };
 
 			using Index = short;
 			enum { IndexNotFound = ~Index(0) };
 
-#pragma pack(push, 2)
-			struct IndexedAddress
+			void* AllocWithIndex(Index index, size_t size = UnitSize, bool* zeroFilled = NULL)
 			{
-				uintptr_t address;
-				Index index;
-			};
-#pragma pack(pop)
+				DKASSERT_MEM_DEBUG(index != IndexNotFound);
+				DKASSERT_MEM_DEBUG(size <= UnitSize);
+				size_t unitClass = 0;
+				while ((size_t(MinUnitSize) << unitClass) < size)
+					unitClass++;
 
-			void* AllocWithIndex(Index index)
-			{
 				ScopedLock guard(lock);
-				void* p = allocator.Alloc(UnitSize);
-				if (p)
+				Slot* slot = partialSlots[unitClass];
+				Region* region = NULL;
+				if (slot)
 				{
-					if (indexAddrsCapacity < numIndexAddrs + 1)
-					{
-						size_t caps = (indexAddrsCapacity + IndexTableAlignment) & ~(IndexTableAlignment - 1);
-						DKASSERT_MEM_DEBUG(caps >= (numIndexAddrs + 1));
-						IndexedAddress* tmp = (IndexedAddress*)SystemHeapAllocator::Realloc(indexAddrs, sizeof(IndexedAddress) * caps);
-						if (tmp)
-						{
-							indexAddrs = tmp;
-							indexAddrsCapacity = caps;
-						}
-						else // out of memory!?
-						{
-							allocator.Dealloc(p);
-							return NULL;
-						}
-					}
-
-					uintptr_t baseAddr = reinterpret_cast<uintptr_t>(p);
-					size_t addrIndex = 0;
-					if (numIndexAddrs > 0)
+					region = FindRegion(slot->address);
+				}
+				else
+				{
+					bool slotZeroFilled = false;
+					void* p = allocator.Alloc(UnitSize, &slotZeroFilled);
+					if (p == NULL)
+						return NULL;
+					uintptr_t address = reinterpret_cast<uintptr_t>(p);
+					region = FindRegion(address);
+					DKASSERT_MEM_DEBUG(region != NULL);
+					slot = &region->slots[(address - region->address) >> UnitSizeShift];
+					if (slot->decommitted)
 					{
-						addrIndex = FindAddress(baseAddr) + 1;
-						if (addrIndex < numIndexAddrs)
-						{
-#if 1
-							memmove(&indexAddrs[addrIndex + 1], &indexAddrs[addrIndex], sizeof(IndexedAddress) * (numIndexAddrs - addrIndex));
-#else
-							for (size_t i = numIndexAddrs; i > addrIndex; --i)
-								indexAddrs[i] = indexAddrs[i - 1];
-#endif
-						}
+						size_t pageSize = DKMemoryPageSize();
+						DKMemoryPageCommit(reinterpret_cast<void*>(address + pageSize), UnitSize - pageSize);
+						slot->decommitted = false;
 					}
-					indexAddrs[addrIndex].index = index;
-					indexAddrs[addrIndex].address = baseAddr;
-					numIndexAddrs++;
+					slot->address = address;
+					slot->usedUnits = 0;
+					slot->touchedUnits = 0;
+					slot->unitClass = (uint8_t)unitClass;
+					slot->zeroFilled = slotZeroFilled;
+					LinkSlot(slot);
 				}
-				return p;
+				DKASSERT_MEM_DEBUG(region != NULL);
+				DKASSERT_MEM_DEBUG(slot->unitClass == unitClass);
+
+				uint32_t unit = 0;
+				while (slot->usedUnits & (1U << unit))
+					unit++;
+				uint32_t bit = 1U << unit;
+				slot->usedUnits |= bit;
+				if (slot->usedUnits == FullMask(unitClass))
+					UnlinkSlot(slot);
+
+				if (zeroFilled)
+					*zeroFilled = slot->zeroFilled && (slot->touchedUnits & bit) == 0;
+				slot->touchedUnits |= bit;
+
+				uintptr_t address = slot->address + (uintptr_t(unit) << (MinUnitSizeShift + unitClass));
+				size_t granule = (address - region->address) >> MinUnitSizeShift;
+				for (size_t i = 0, n = size_t(1) << unitClass; i < n; ++i)
+					region->indices[granule + i] = index;
+				return reinterpret_cast<void*>(address);
 			}
 			Index Dealloc(void* p)
 			{
+				uintptr_t address = reinterpret_cast<uintptr_t>(p);
 				ScopedLock guard(lock);
-				DKASSERT_MEM_DEBUG(numIndexAddrs > 0);
-				size_t addrIndex = FindAddress(reinterpret_cast<uintptr_t>(p));
-				DKASSERT_MEM_DEBUG(addrIndex < numIndexAddrs);
-				Index index = indexAddrs[addrIndex].index;
-				numIndexAddrs--;
-				if (numIndexAddrs > 0)
-				{
-#if 1
-					if (addrIndex < numIndexAddrs)
-						memmove(&indexAddrs[addrIndex], &indexAddrs[addrIndex + 1], sizeof(IndexedAddress) * (numIndexAddrs - addrIndex));
-#else
-					for (size_t i = addrIndex; i < numIndexAddrs; ++i)
-						indexAddrs[i] = indexAddrs[i+1];
-#endif
+				Region* region = FindRegion(address);
+				DKASSERT_MEM_DEBUG(region != NULL);
+				size_t granule = (address - region->address) >> MinUnitSizeShift;
+				Slot* slot = &region->slots[(address - region->address) >> UnitSizeShift];
+				size_t unitClass = slot->unitClass;
+				uint32_t unit = uint32_t((address - slot->address) >> (MinUnitSizeShift + unitClass));
+				uint32_t bit = 1U << unit;
+				DKASSERT_MEM_DESC_DEBUG(slot->address + (uintptr_t(unit) << (MinUnitSizeShift + unitClass)) == address, "Invalid address!");
+				DKASSERT_MEM_DESC_DEBUG(slot->usedUnits & bit, "Invalid address!");
+
+				Index index = region->indices[granule];
+				for (size_t i = 0, n = size_t(1) << unitClass; i < n; ++i)
+					region->indices[granule + i] = IndexNotFound;
+
+				bool linked = slot->usedUnits != FullMask(unitClass);
+				slot->usedUnits &= ~bit;
+				if (slot->usedUnits == 0)
+				{
+					if (linked)
+						UnlinkSlot(slot);
+					allocator.Dealloc(reinterpret_cast<void*>(slot->address));
+				}
+				else if (!linked)
+				{
+					LinkSlot(slot);
 				}
-				allocator.Dealloc(p);
 				return index;
 			}
 			Index IndexForAddress(void* p)
 			{
-				uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+				uintptr_t address = reinterpret_cast<uintptr_t>(p);
 				ScopedLock guard(lock);
-				size_t addrIndex = FindAddress(addr);
-				if (addrIndex < numIndexAddrs && addr < indexAddrs[addrIndex].address + UnitSize)
-					return indexAddrs[addrIndex].index;
+				Region* region = FindRegion(address);
+				if (region)
+					return region->indices[(address - region->address) >> MinUnitSizeShift];
 				return IndexNotFound;
 			}
-			size_t PurgeThreshold(size_t threshold)
+			size_t NumberOfUnitsWithIndex(Index index)
 			{
 				ScopedLock guard(lock);
-				size_t r = allocator.ConditionalPurge(threshold);
-				if (r > 0 || threshold == 0)
+				size_t count = 0;
+				for (Region* region = regions; region; region = region->next)
 				{
-					size_t alignedNumIndexAddrs = (numIndexAddrs + IndexTableAlignment - 1) & ~(IndexTableAlignment - 1);
-					if (alignedNumIndexAddrs < indexAddrsCapacity)
+					for (const Slot& slot : region->slots)
 					{
-						if (numIndexAddrs > 0)
+						for (uint32_t unit = 0; (slot.usedUnits >> unit) != 0; ++unit)
 						{
-							size_t caps = alignedNumIndexAddrs;
-							DKASSERT_MEM_DEBUG((caps % IndexTableAlignment) == 0);
-							IndexedAddress* tmp = (IndexedAddress*)SystemHeapAllocator::Realloc(indexAddrs, sizeof(IndexedAddress) * caps);
-							if (tmp)
-							{
-								indexAddrs = tmp;
-								indexAddrsCapacity = caps;
-							}
-							else
+							if (slot.usedUnits & (1U << unit))
 							{
-								// out of memory! nothing changed.
+								uintptr_t address = slot.address + (uintptr_t(unit) << (MinUnitSizeShift + slot.unitClass));
+								if (region->indices[(address - region->address) >> MinUnitSizeShift] == index)
+									count++;
 							}
 						}
-						else
+					}
+				}
+				return count;
+			}
+			size_t PurgeThreshold(size_t threshold)
+			{
+				ScopedLock guard(lock);
+				return allocator.ConditionalPurge(threshold);
+			}
+			// release empty regions, and return pages of remaining empty slots
+			// to system. scans all slots, not called by free path.
+			size_t Purge(void)
+			{
+				ScopedLock guard(lock);
+				size_t purged = allocator.ConditionalPurge(0);
+				// regions are released only if all slots are empty. first page
+				// of slot is kept, which holds free-list link of slot allocator.
+				size_t pageSize = DKMemoryPageSize();
+				for (Region* region = regions; region; region = region->next)
+				{
+					for (Slot& slot : region->slots)
+					{
+						if (slot.address && slot.usedUnits == 0 && !slot.decommitted)
 						{
-							SystemHeapAllocator::Free(indexAddrs);
-							indexAddrs = NULL;
-							indexAddrsCapacity = 0;
+							DKMemoryPageDecommit(reinterpret_cast<void*>(slot.address + pageSize), UnitSize - pageSize);
+							slot.decommitted = true;
 						}
 					}
 				}
-				return r;
+				return purged;
 			}
 			size_t Size(void) const
 			{
 				ScopedLock guard(lock);
-				return (sizeof(IndexedAddress) * indexAddrsCapacity) + allocator.Size();
+				return allocator.Size() + numRegions * sizeof(Region) + regionTable.Size();
+			}
+			// release all units at once.
+			void Clear(void)
+			{
+				ScopedLock guard(lock);
+				allocator.Clear();
+				DKASSERT_MEM_DEBUG(regions == NULL);
+				for (Slot*& slot : partialSlots)
+					slot = NULL;
 			}
-			BackendAllocator(void)
-				: numIndexAddrs(0)
-				, indexAddrsCapacity(0)
-				, indexAddrs(NULL)
+			BackendAllocatorT(void)
+				: allocator(RegionAllocator{ this })
+				, regions(NULL)
+				, numRegions(0)
 			{
+				for (Slot*& slot : partialSlots)
+					slot = NULL;
 			}
-			~BackendAllocator(void)
+			~BackendAllocatorT(void)
 			{
-				if (indexAddrsCapacity > 0)
-					SystemHeapAllocator::Free(indexAddrs);
 			}
+
+			BackendAllocatorT(const BackendAllocatorT&) = delete;
+			BackendAllocatorT& operator = (const BackendAllocatorT&) = delete;
+
 		private:
-			FORCEINLINE size_t FindAddress(uintptr_t addr)
+			struct Slot
+			{
+				Slot* prev;				// list of slots have free units. (partialSlots)
+				Slot* next;
+				uintptr_t address;
+				uint16_t usedUnits;		// bitmask of allocated units
+				uint16_t touchedUnits;	// bitmask of units have been used
+				uint8_t unitClass;
+				bool zeroFilled;		// slot was zero-filled when allocated
+				bool decommitted;		// empty slot, pages returned to system
+			};
+			struct Region
+			{
+				uintptr_t address;
+				Region* next;
+				Slot slots[SlotsPerRegion];
+				Index indices[GranulesPerRegion];	// bucket index of each granule
+			};
+			// RegionTable : two-level table of regions, indexed by address.
+			//   leaves are allocated on demand, released with backend.
+			struct RegionTable
 			{
-				// lower-bound search.
-				size_t start = 0;
-				size_t count = numIndexAddrs;
-				size_t med;
-				while (count > 1)
+				enum { LeafSize = (1 << LeafBits) };
+				Region** leaves[1 << RootBits];
+				size_t numLeaves;
+
+				RegionTable(void) : numLeaves(0)
+				{
+					for (Region**& leaf : leaves)
+						leaf = NULL;
+				}
+				~RegionTable(void)
 				{
-					med = count >> 1;
-					if (addr < indexAddrs[start + med].address)
+					for (Region** leaf : leaves)
 					{
-						count = med;
+						if (leaf)
+							MetadataAllocator::Free(leaf);
 					}
-					else
+				}
+				FORCEINLINE Region** Find(uintptr_t address, bool create)
+				{
+					uint64_t r = uint64_t(address) >> RegionShift;
+					if ((r >> RegionBits) != 0)
+						return NULL;	// out of range.
+					Region**& leaf = leaves[size_t(r >> LeafBits)];
+					if (leaf == NULL && create)
+					{
+						leaf = (Region**)MetadataAllocator::Alloc(sizeof(Region*) * LeafSize);
+						if (leaf == NULL)
+							return NULL;
+						memset(leaf, 0, sizeof(Region*) * LeafSize);
+						numLeaves++;
+					}
+					if (leaf)
+						return &leaf[size_t(r & (LeafSize - 1))];
+					return NULL;
+				}
+				size_t Size(void) const
+				{
+					return sizeof(Region*) * LeafSize * numLeaves;
+				}
+			};
+			// RegionAllocator : allocates regions for slots, aligned with RegionSize.
+			struct RegionAllocator
+			{
+				BackendAllocatorT* backend;
+
+				void* Alloc(size_t s)
+				{
+					bool zeroFilled;
+					return Alloc(s, &zeroFilled);
+				}
+				void* Alloc(size_t s, bool* zeroFilled)
+				{
+					DKASSERT_MEM_DEBUG(s == RegionSize);
+					(void)s;
+					void* p = VirtualAlignedAlloc(RegionSize, RegionSize);
+					if (p && !backend->InsertRegion(reinterpret_cast<uintptr_t>(p)))
+					{
+						DKMemoryVirtualFree(p);
+						p = NULL;
+					}
+					*zeroFilled = true;	// VM pages are zero-filled
+					return p;
+				}
+				void Free(void* p)
+				{
+					backend->RemoveRegion(reinterpret_cast<uintptr_t>(p));
+					DKMemoryVirtualFree(p);
+				}
+			};
+			using Allocator = DKFixedSizeAllocator<UnitSize, 1, SlotsPerRegion, DKDummyLock, MetadataAllocator, RegionAllocator>;
+
+			FORCEINLINE static uint32_t FullMask(size_t unitClass)
+			{
+				return (1U << ((UnitSize / MinUnitSize) >> unitClass)) - 1;
+			}
+			FORCEINLINE Region* FindRegion(uintptr_t address)
+			{
+				Region** r = regionTable.Find(address, false);
+				return r ? *r : NULL;
+			}
+			bool InsertRegion(uintptr_t address)
+			{
+				DKASSERT_MEM_DEBUG((address % RegionSize) == 0);
+				Region** r = regionTable.Find(address, true);
+				if (r == NULL)
+					return false;
+				DKASSERT_MEM_DEBUG(*r == NULL);
+				Region* region = (Region*)MetadataAllocator::Alloc(sizeof(Region));
+				if (region == NULL)
+					return false;
+				memset(region, 0, sizeof(Region));
+				for (Index& index : region->indices)
+					index = IndexNotFound;
+				region->address = address;
+				region->next = regions;
+				regions = region;
+				numRegions++;
+				*r = region;
+				return true;
+			}
+			void RemoveRegion(uintptr_t address)
+			{
+				Region** r = regionTable.Find(address, false);
+				DKASSERT_MEM_DEBUG(r && *r);
+				Region* region = *r;
+				*r = NULL;
+				for (Region** p = &regions; *p; p = &(*p)->next)
+				{
+					if (*p == region)
 					{
-						start += med;
-						count -= med;
+						*p = region->next;
+						break;
 					}
 				}
-				if (count > 0 && addr >= indexAddrs[start].address)
-					return start;
-				return ~size_t(0);
+				numRegions--;
+				MetadataAllocator::Free(region);
+			}
+			FORCEINLINE void LinkSlot(Slot* slot)
+			{
+				if (slot->usedUnits == FullMask(slot->unitClass))
+					return;	// slot of 256KB chunk is never linked.
+				slot->prev = NULL;
+				slot->next = partialSlots[slot->unitClass];
+				if (slot->next)
+					slot->next->prev = slot;
+				partialSlots[slot->unitClass] = slot;
+			}
+			FORCEINLINE void UnlinkSlot(Slot* slot)
+			{
+				if (slot->prev)
+					slot->prev->next = slot->next;
+				else
+				{
+					DKASSERT_MEM_DEBUG(partialSlots[slot->unitClass] == slot);
+					partialSlots[slot->unitClass] = slot->next;
+				}
+				if (slot->next)
+					slot->next->prev = slot->prev;
+				slot->prev = NULL;
+				slot->next = NULL;
 			}
 
-			using Lock = DKSpinLock;
 			using ScopedLock = DKCriticalSection<Lock>;
-			Lock			lock;
+			// lock is placed in its own cache line, waiting threads
+			// do not invalidate states of lock owner.
+			alignas(DKGL_CACHE_LINE_SIZE) Lock lock;
+			alignas(DKGL_CACHE_LINE_SIZE) RegionTable regionTable;	// must be destroyed after allocator.
 			Allocator		allocator;
-			IndexedAddress*	indexAddrs;
-			size_t			indexAddrsCapacity;
-			size_t			numIndexAddrs;
+			Slot*			partialSlots[NumUnitClasses];
+			Region*			regions;
+			size_t			numRegions;
 		};
+		using BackendAllocator = BackendAllocatorT<DKSpinLock>;
+		static BackendAllocator* SharedBackendAllocator(void);	// init by main allocator. (AllocatorPool)
 
 
-		// ChunkAllocator : allocates chunks for front-end allocators.
-		//   This is wrapper of BackendAllocator and keep track address that
-		//   was allocated by BackendAllocator.
-		template <int Index> struct ChunkAllocator
-		{
-			enum { UnitSize = BackendAllocator::UnitSize };
+		static_assert(size_t(PoolBucketClass::MaxChunkSize) == size_t(BackendAllocator::UnitSize), "Wrong size!");
 
-			FORCEINLINE static void* Alloc(size_t s)
-			{
-				DKASSERT_MEM_DEBUG(s <= UnitSize);
-				return BackendAllocator::Instance()->AllocWithIndex(Index);
-			}
-			FORCEINLINE static void Free(void* p)
+		// PoolBucketConfig : buckets of memory pool. (shared, thread-safe)
+		//   bucket type is declared in DKMallocConst.h, to be used directly.
+		struct PoolBucketConfig
+		{
+			using Lock = DKSpinLock;
+			using Backend = BackendAllocator;
+			using BaseAllocator = PoolBucketMetadataAllocator;
+			using UnitAllocator = PoolBucketChunkAllocator;
+			static UnitAllocator CreateUnitAllocator(Backend*, size_t index)
 			{
-				int index = BackendAllocator::Instance()->Dealloc(p);
-				DKASSERT_MEM_DEBUG(index == Index);
+				UnitAllocator allocator = { index };
+				return allocator;
 			}
 		};
 
-		struct AllocatorInterface
-		{
-			virtual ~AllocatorInterface(void) noexcept(!DKGL_MEMORY_DEBUG) {}
-			virtual void* Alloc(size_t) = 0;
-			virtual void Dealloc(void*) = 0;
-			virtual size_t Purge(void) = 0;
-			virtual void Reserve(size_t) = 0;
-			virtual void* AlignedChunkAddress(void*) const = 0;
-			virtual size_t ChunkSize(void) const = 0;
-
-			virtual bool ConditionalDealloc(void*) = 0;
-			virtual size_t ConditionalPurge(size_t) = 0;
-			virtual bool ConditionalDeallocAndPurge(void*, size_t, size_t*) = 0;
-
-			virtual size_t NumberOfAllocatedUnits(void) const = 0;
-			virtual size_t NumberOfUnits(void) const = 0;
-		};
+		enum { NumAllocatorUnits = PoolBucketClass::NumBuckets };	// allocator buckets
 
-		struct AllocatorUnit
-		{
-			size_t unitSize;
-			AllocatorInterface* allocator;
-		};
+		// AllocatorUnit : bucket allocator, unit size is given at runtime.
+		//   every bucket has same type, buckets are stored inline (no virtual call)
+		//   each bucket is aligned with cache line, container must be aligned too.
+		template <typename Config> using AllocatorUnit = PoolBucketAllocatorT<
+			typename Config::Lock, typename Config::BaseAllocator, typename Config::UnitAllocator>;
+		static_assert(std::is_same<AllocatorUnit<PoolBucketConfig>, PoolBucketAllocator>::value, "Bucket type mismatch!");
 
-		template <
-			int Size,
-			int SizeOffset,
-			int Alignment,
-			int Index,
-			int Count
-		>
-		struct Initializer
+		// create all buckets (FirstUnitSize ~ 32768), sizes are from PoolBucketClass.
+		// baseIndex : backend index of first bucket, for multiple sets of buckets.
+		template <typename Config> static void InitAllocatorUnits(AllocatorUnit<Config>* units, size_t* unitSizes, typename Config::Backend* backend, size_t baseIndex = 0)
 		{
-			using UnitAllocator = ChunkAllocator<Index>;
-
-			enum { UnitSize = Size };
-			enum { MaxChunkSize = UnitAllocator::UnitSize };
-			enum { NumUnits = (MaxChunkSize - Alignment + 1) / UnitSize };
-			static_assert((UnitSize % Alignment) == 0, "Wrong unit size!");
-			static_assert((UnitSize % 16) == 0, "Invalid size, size must be aligned with 16bytes");
+			using Unit = AllocatorUnit<Config>;
+			enum { MaxChunkSize = Config::Backend::UnitSize };
+			enum { MinChunkSize = Config::Backend::MinUnitSize };
+			// first chunk of bucket should have 16 units at least,
+			// chunk size grows up to MaxChunkSize as bucket grows.
+			enum { MinUnitsPerChunk = 16 };
+
+			size_t prevUnitSize = 0;
+			for (size_t i = 0; i < NumAllocatorUnits; ++i)
+			{
+				size_t unitSize = (i == 0) ? size_t(PoolBucketClass::FirstUnitSize) : PoolBucketClass::Next(prevUnitSize);
+				size_t numUnits = PoolBucketClass::NumUnits(i);
+				DKASSERT_MEM_DEBUG(unitSize == PoolBucketClass::UnitSize(i));
+				// size must be aligned with 16bytes, except for tiny classes.
+				DKASSERT_MEM_DEBUG((unitSize % 16) == 0 || unitSize < PoolBucketClass::MinUnitSize);
+				size_t minChunkSize = MinChunkSize;
+				while (minChunkSize < MaxChunkSize && minChunkSize < unitSize * MinUnitsPerChunk)
+					minChunkSize = minChunkSize << 1;
+#if DKGL_MEMORY_DEBUG
+				// waste: largest internal fragmentation of unit (prevUnitSize+1 bytes)
+				DKLog("Allocator[%d]: (size:%d, units:%d, chunkSize:%d-%d/%d usage:%.2f%%, waste:%.2f%%)\n",
+					  (int)i, (int)unitSize, (int)numUnits, (int)minChunkSize, (int)(unitSize * numUnits), (int)MaxChunkSize,
+					  ((double)(unitSize * numUnits) / (double)MaxChunkSize) * 100.0,
+					  ((double)(unitSize - prevUnitSize - 1) / (double)unitSize) * 100.0);
+#endif
+				unitSizes[i] = unitSize;
+				::new (&units[i]) Unit(unitSize, 1, minChunkSize, MaxChunkSize, Config::CreateUnitAllocator(backend, baseIndex + i));
+#if DKGL_MEMORY_CACHE_COLORING
+				units[i].SetChunkColoring(DKGL_CACHE_LINE_SIZE);
+#endif
+				DKASSERT_MEM_DEBUG(units[i].UnitStride() == unitSize);
+				(void)numUnits;
+				prevUnitSize = unitSize;
+			}
+		}
 
-			struct Wrapper : public AllocatorInterface
+		// binary search unit for size, from sorted unit sizes.
+		FORCEINLINE static size_t FindAllocatorUnitForSize(const size_t* unitSizes, size_t count, size_t size)
+		{
+			size_t start = 0;
+			size_t med;
+			while (count > 0)
 			{
-				void* Alloc(size_t s) override						{ return allocator.Alloc(s); }
-				void Dealloc(void* p) override						{ return allocator.Dealloc(p); }
-				size_t Purge(void) override							{ return allocator.Purge(); }
-				void Reserve(size_t s) override						{ return allocator.Reserve(s); }
-				void* AlignedChunkAddress(void* p) const override	{ return allocator.AlignedChunkAddress(p); }
-				size_t ChunkSize(void) const override				{ return allocator.AlignedChunkSize; }
-
-				bool ConditionalDealloc(void* p) override			{ return allocator.ConditionalDealloc(p); }
-				size_t ConditionalPurge(size_t c) override			{ return allocator.ConditionalPurge(c); }
-				bool ConditionalDeallocAndPurge(void* p, size_t s, size_t* bp) override
+				med = count / 2;
+				if (size > unitSizes[start + med])
 				{
-					return allocator.ConditionalDeallocAndPurge(p, s, bp);
+					start += med + 1;
+					count -= med + 1;
+				}
+				else
+				{
+					count = med;
 				}
-
-				size_t NumberOfAllocatedUnits(void) const override	{ return allocator.NumberOfAllocatedUnits(); }
-				size_t NumberOfUnits(void) const override			{ return allocator.NumberOfUnits(); }
-
-				using Allocator = DKFixedSizeAllocator<UnitSize, Alignment, NumUnits, DKSpinLock, SystemHeapAllocator, UnitAllocator>;
-				Allocator allocator;
-				static_assert(Allocator::AlignedChunkSize <= MaxChunkSize, "Wrong size!");
-			};
-
-			static int Init(AllocatorUnit* units)
-			{
-#if DKGL_MEMORY_DEBUG
-				DKLog("Allocator[%d]: (size:%d, alignment:%d, units:%d, chunkSize:%d/%d usage:%.2f%%)\n",
-					  Index, UnitSize, Alignment, NumUnits, Wrapper::Allocator::AlignedChunkSize, MaxChunkSize,
-					  ((double)Wrapper::Allocator::AlignedChunkSize / (double)MaxChunkSize) * 100.0);
-#endif
-				units[Index].unitSize = UnitSize;
-				units[Index].allocator = ::new (SystemHeapAllocator::Alloc(sizeof(Wrapper))) Wrapper();
-				return 1 + Initializer<UnitSize + SizeOffset, SizeOffset, Alignment, Index+1, Count-1>::Init(units);
 			}
-		};
-		template <int Size, int SizeOffset, int Alignment, int Index>
-		struct Initializer<Size, SizeOffset, Alignment, Index, 0> //sentinel
+			return start;
+		}
+
+		// fill zero with non-temporal stores for large block, to avoid cache pollution.
+		static void ZeroFill(void* p, size_t s)
 		{
-			static int Init(AllocatorUnit*) { return 0; }
-		};
+			enum { NonTemporalThreshold = 16384 };
+#ifdef DKGL_SSE2_ENABLED
+			if (s >= NonTemporalThreshold && (reinterpret_cast<uintptr_t>(p) % 16) == 0)
+			{
+				const __m128i zero = _mm_setzero_si128();
+				__m128i* dst = reinterpret_cast<__m128i*>(p);
+				size_t n = s / 64;
+				for (size_t i = 0; i < n; ++i)
+				{
+					_mm_stream_si128(dst++, zero);
+					_mm_stream_si128(dst++, zero);
+					_mm_stream_si128(dst++, zero);
+					_mm_stream_si128(dst++, zero);
+				}
+				_mm_sfence();
+				p = dst;
+				s = s % 64;
+			}
+#endif
+			if (s > 0)
+				memset(p, 0, s);
+		}
 
 		struct AllocatorPool : public DKAllocator
 		{
-			enum { NumAllocators = 128 };	// allocator buckets
+			enum { NumAllocators = NumAllocatorUnits };	// allocator buckets
+			enum { NumLifetimes = DKMemoryLifetimeCold + 1 };	// set of buckets for each lifetime hint
+			enum { NumUnits = NumAllocators * NumLifetimes };
+			enum { ExternalChunkIndex = NumUnits };	// backend index of chunks for ChunkAlloc
+			using AllocatorUnit = Private::AllocatorUnit<PoolBucketConfig>;
 
-			AllocatorPool(void) : backend(NULL)
+			// pool is allocated with VM pages, to align buckets with cache line.
+			void* operator new (size_t s)
 			{
-#ifdef _WIN32
-				// reserve 64 MB heap
-				SystemHeapAllocator::heap = ::HeapCreate(0, (1<<26), 0);
-#endif
-				backend = ::new (SystemHeapAllocator::Alloc(sizeof(BackendAllocator))) BackendAllocator();
-
-				// Initializer < Size, SizeOffset, Alignment, Index, Count>
-
-				int count = 0;
-				// 16 ~ 256 (16 bytes offset, 16 units)
-				count += Initializer<16, 16, 1, 0, 16>::Init(allocators);
-				// 256+16 ~ 512 (16 bytes offset, 16 units)
-				count += Initializer<256 + 16, 16, 1, 16, 16>::Init(allocators);
-				// 512+32 ~ 1024 (32 bytes offset, 16 units)
-				count += Initializer<512 + 32, 32, 1, 32, 16>::Init(allocators);
-				// 1024+64 ~ 2048 (64 bytes offset, 16 units)
-				count += Initializer<1024 + 64, 64, 1, 48, 16>::Init(allocators);
-				// 2048+128 ~ 4096 (128 bytes offset, 16 units)
-				count += Initializer<2048 + 128, 128, 1, 64, 16>::Init(allocators);
-				// 4096+256 ~ 8192 (256 bytes offset, 16 units)
-				count += Initializer<4096 + 256, 256, 1, 80, 16>::Init(allocators);
-				// 8192+512 ~ 16384 (512 bytes offset, 16 units)
-				count += Initializer<8192 + 512, 512, 1, 96, 16>::Init(allocators);
-				// 16384+1024 ~ 32768 (1024 bytes offset, 16 units)
-				count += Initializer<16384 + 1024, 1024, 1, 112, 16>::Init(allocators);
-				
-				DKASSERT_MEM_DEBUG(count == NumAllocators);
-
-				size_t chunkSize = 0;
-				for (int i = 0; i < count; ++i )
-				{
-					chunkSize += allocators[i].allocator->ChunkSize();
-				}
+				return DKMemoryVirtualAlloc(s);
+			}
+			void operator delete (void* p) noexcept
+			{
+				DKMemoryVirtualFree(p);
+			}
+
+			AllocatorPool(void)
+				: backend(NULL)
+				, bucketPurgeThreshold(DefaultBucketPurgeThreshold)
+				, backendPurgeThreshold(DefaultBackendPurgeThreshold)
+				, chunkPolicy(DKMemoryChunkPolicyDefault)
+			{
+				backend = ::new (DKMemoryVirtualAlloc(sizeof(BackendAllocator))) BackendAllocator();
+
+				// each lifetime has its own buckets, backend index is unit index.
+				for (size_t i = 0; i < NumLifetimes; ++i)
+					InitAllocatorUnits<PoolBucketConfig>(&allocators[i * NumAllocators], unitSizes, backend, i * NumAllocators);
+
 #if DKGL_MEMORY_DEBUG
-				DKLog("AllocatorPool Initialized. (%lu - %lu, Units: %d, ChunkSize: %lu)\n",
-					  allocators[0].unitSize,
-					  allocators[NumAllocators-1].unitSize,
+				DKLog("AllocatorPool Initialized. (%lu - %lu, Units: %d, Bucket: %lu bytes)\n",
+					  unitSizes[0],
+					  unitSizes[NumAllocators-1],
 					  NumAllocators,
-					  chunkSize);
+					  sizeof(AllocatorUnit));
 #endif
-				maxUnitSize = allocators[NumAllocators-1].unitSize;
+				maxUnitSize = unitSizes[NumAllocators-1];
+
+				// options from environment, "name:value,name:value"
+				// no allocation has been made yet, large.cutoff can be set.
+				if (const char* conf = getenv("DKMALLOC_CONF"))
+					Configure(conf);
 			}
 
 			~AllocatorPool(void)
 			{
 				bool cleanupHeap = true;
-				for (int i = 0; i < NumAllocators; ++i)
+				for (int i = 0; i < NumUnits; ++i)
 				{
-					size_t numAllocated = allocators[i].allocator->NumberOfAllocatedUnits();
+					size_t numAllocated = allocators[i].NumberOfAllocatedUnits();
 					if ( numAllocated > 0)
 					{
 						DKLog("MEMORY LEAK WARNING: %llu objects (%d bytes unit) still occupied.\n",
-							  static_cast<unsigned long long>(numAllocated), (int)allocators[i].unitSize);
+							  static_cast<unsigned long long>(numAllocated), (int)unitSizes[i % NumAllocators]);
 						cleanupHeap = false;
 					}
 					else
 					{
-						allocators[i].allocator->~AllocatorInterface();
+						allocators[i].~AllocatorUnit();
 					}
-
-					SystemHeapAllocator::Free(allocators[i].allocator);
 				}
 
 				backend->PurgeThreshold(0);
@@ -470,11 +876,7 @@ namespace DKFoundation
 				if (cleanupHeap)
 				{
 					backend->~BackendAllocator();
-					SystemHeapAllocator::Free(backend);
-
-#ifdef _WIN32
-					::HeapDestroy(SystemHeapAllocator::heap);
-#endif
+					DKMemoryVirtualFree(backend);
 				}
 				else
 				{
@@ -489,13 +891,76 @@ namespace DKFoundation
 
 				AllocatorUnit* unit = FindAllocatorForSize(s);
 				DKASSERT_MEM_DEBUG(unit != NULL);
-				DKASSERT_MEM_DEBUG(unit->unitSize >= s);
-				return unit->allocator->Alloc(s);
+				DKASSERT_MEM_DEBUG(unit->UnitLength() >= s);
+				return unit->Alloc(s);
 			}
 
-			void* Realloc(void* p, size_t s)
+			// allocate from buckets of lifetime, large blocks are not affected.
+			void* HintAlloc(size_t s, DKMemoryLifetime lifetime)
 			{
-				if (p)
+				if (s > this->maxUnitSize)
+					return SystemLargeHeapAllocator::Alloc(s);
+
+				AllocatorUnit* unit = FindAllocatorForSize(s, lifetime);
+				DKASSERT_MEM_DEBUG(unit != NULL);
+				DKASSERT_MEM_DEBUG(unit->UnitLength() >= s);
+				return unit->Alloc(s);
+			}
+
+			// allocate near hint if hint is in bucket of same size. (and same lifetime)
+			void* AllocNear(void* hint, size_t s)
+			{
+				if (hint && s <= this->maxUnitSize)
+				{
+					AllocatorUnit* unit = FindAllocator(hint);
+					if (unit && unit == FindAllocatorForSize(s, LifetimeOfAllocator(unit)))
+						return unit->AllocNear(hint, s);
+				}
+				return Alloc(s);
+			}
+
+			void* AlignedAlloc(size_t s, size_t alignment)
+			{
+				DKASSERT_MEM_DEBUG((alignment & (alignment - 1)) == 0);
+				if (alignment <= 16)
+					return Alloc(Max(s, alignment));	// tiny classes are aligned with unit size.
+
+				if (alignment <= DKMemoryPageSize())
+				{
+					AllocatorUnit* unit = FindAllocatorForAlignedSize(s, alignment);
+					if (unit)
+					{
+						void* p = unit->Alloc(s);
+						DKASSERT_MEM_DEBUG((reinterpret_cast<uintptr_t>(p) % alignment) == 0);
+						return p;
+					}
+					return SystemLargeHeapAllocator::AlignedAlloc(s);
+				}
+				return VirtualAlignedAlloc(s, alignment);
+			}
+
+			void* Calloc(size_t num, size_t size)
+			{
+				size_t s = num * size;
+				if (size > 0 && s / size != num)
+					return NULL;	// overflow
+
+				if (s > this->maxUnitSize)
+					return SystemLargeHeapAllocator::Alloc(s); // VM pages are zero-filled.
+
+				AllocatorUnit* unit = FindAllocatorForSize(s);
+				DKASSERT_MEM_DEBUG(unit != NULL);
+				DKASSERT_MEM_DEBUG(unit->UnitLength() >= s);
+				bool zeroFilled = false;
+				void* p = unit->Alloc(s, &zeroFilled);
+				if (p && !zeroFilled)
+					ZeroFill(p, s);
+				return p;
+			}
+
+			void* Realloc(void* p, size_t s)
+			{
+				if (p)
 				{
 					AllocatorUnit* unit = FindAllocator(p);
 					if (unit)
@@ -507,14 +972,15 @@ namespace DKFoundation
 						}
 						else
 						{
-							AllocatorUnit* unit2 = FindAllocatorForSize(s);
+							// stay in buckets of same lifetime.
+							AllocatorUnit* unit2 = FindAllocatorForSize(s, LifetimeOfAllocator(unit));
 							if (unit2 == unit)
 								return p;
-							p2 = unit2->allocator->Alloc(s);
+							p2 = unit2->Alloc(s);
 						}
 						if (p2)
 						{
-							size_t bytesToCopy = Min(s, unit->unitSize);
+							size_t bytesToCopy = Min(s, unit->UnitLength());
 							memcpy(p2, p, bytesToCopy);
 							if (!DeallocAndPurge(unit, p))
 							{
@@ -533,7 +999,7 @@ namespace DKFoundation
 						{
 							unit = FindAllocatorForSize(s);
 							DKASSERT_MEM_DEBUG(unit);
-							void* p2 = unit->allocator->Alloc(s);
+							void* p2 = unit->Alloc(s);
 							if (p2)
 							{
 								memcpy(p2, p, s);
@@ -564,119 +1030,664 @@ namespace DKFoundation
 				}
 			}
 
+			// size must be the size requested to Alloc. (or Realloc)
+			// bucket is selected by size, without looking up address.
+			void DeallocSized(void* p, size_t s)
+			{
+				if (p)
+				{
+					if (s > this->maxUnitSize)
+					{
+						DKASSERT_MEM_DEBUG(FindAllocator(p) == NULL);
+						SystemLargeHeapAllocator::Free(p);
+						return;
+					}
+					AllocatorUnit* unit = FindAllocatorForSize(s);
+					DKASSERT_MEM_DEBUG(unit == FindAllocator(p));
+					if (!DeallocAndPurge(unit, p))
+					{
+						DKASSERT_MEM_DESC_DEBUG(0, "Invalid size!");
+						Dealloc(p);
+					}
+				}
+			}
+
+			// size, alignment must be the values requested to AlignedAlloc.
+			void AlignedDeallocSized(void* p, size_t s, size_t alignment)
+			{
+				DKASSERT_MEM_DEBUG((alignment & (alignment - 1)) == 0);
+				if (alignment <= 16)
+					return DeallocSized(p, Max(s, alignment));
+
+				if (p)
+				{
+					AllocatorUnit* unit = NULL;
+					if (alignment <= DKMemoryPageSize())
+						unit = FindAllocatorForAlignedSize(s, alignment);
+					DKASSERT_MEM_DEBUG(unit == FindAllocator(p));
+					if (unit == NULL)
+					{
+						SystemLargeHeapAllocator::Free(p);
+					}
+					else if (!DeallocAndPurge(unit, p))
+					{
+						DKASSERT_MEM_DESC_DEBUG(0, "Invalid size or alignment!");
+						Dealloc(p);
+					}
+				}
+			}
+
+			size_t UsableSize(void* p)
+			{
+				if (p)
+				{
+					AllocatorUnit* unit = FindAllocator(p);
+					if (unit)
+						return unit->UnitLength();
+					return SystemLargeHeapAllocator::Size(p);
+				}
+				return 0;
+			}
+
+			size_t GoodSize(size_t s) const
+			{
+				if (s > this->maxUnitSize)
+				{
+					size_t pageSize = DKMemoryPageSize();
+					if (s % pageSize)
+						s += pageSize - (s % pageSize);
+					return s;
+				}
+				return FindAllocatorForSize(s)->UnitLength();
+			}
+
+			bool TryExpand(void* p, size_t s)
+			{
+				if (p)
+				{
+					AllocatorUnit* unit = FindAllocator(p);
+					if (unit)	// sized free of s must find same bucket.
+						return s <= unit->UnitLength() && s <= this->maxUnitSize;
+					// allocated from SystemLargeHeapAllocator.
+					return SystemLargeHeapAllocator::TryExpand(p, s);
+				}
+				return false;
+			}
+
+			// allocate whole backend chunk, not used by buckets.
+			void* ChunkAlloc(void)
+			{
+				return backend->AllocWithIndex(ExternalChunkIndex, BackendAllocator::UnitSize);
+			}
+
+			void ChunkDealloc(void* p)
+			{
+				if (p)
+				{
+					BackendAllocator::Index index = backend->Dealloc(p);
+					DKASSERT_MEM_DESC_DEBUG(index == ExternalChunkIndex, "Address was not allocated by ChunkAlloc!");
+					(void)index;
+					PurgeBackend();
+				}
+			}
+
+			// release empty backend slots, keeps backendPurgeThreshold slots.
+			FORCEINLINE void PurgeBackend(void)
+			{
+				backend->PurgeThreshold(backendPurgeThreshold.load(std::memory_order_relaxed));
+			}
+
+			void SetChunkPolicy(DKMemoryChunkPolicy policy)
+			{
+				chunkPolicy.store(policy, std::memory_order_relaxed);
+				for (size_t i = 0; i < NumUnits; ++i)
+					allocators[i].SetChunkPolicy(policy);
+			}
+
+			// runtime tuning, see DKMemoryPoolControl.
+			// init is true while pool is being initialized. (DKMALLOC_CONF)
+			int Control(const char* name, const size_t* in, size_t* out, bool init = false)
+			{
+				if (strcmp(name, "purge.bucket_threshold") == 0)
+					return ControlValue(bucketPurgeThreshold, in, out);
+				if (strcmp(name, "purge.backend_threshold") == 0)
+					return ControlValue(backendPurgeThreshold, in, out);
+				if (strcmp(name, "large.cutoff") == 0)
+				{
+					// sized free selects bucket by size, allocations made before
+					// and after cutoff changed can not be told. (init only)
+					if (in && !init)
+						return EPERM;
+					// buckets are fixed, cutoff can not exceed largest bucket.
+					if (in && *in > unitSizes[NumAllocators-1])
+						return EINVAL;
+					if (in)
+					{
+						// round down to unit size, every bucket block fits in cutoff.
+						size_t cutoff = 0;
+						for (size_t i = 0; i < NumAllocators && unitSizes[i] <= *in; ++i)
+							cutoff = unitSizes[i];
+						if (cutoff == 0)
+							return EINVAL;
+						return ControlValue(maxUnitSize, &cutoff, out);
+					}
+					return ControlValue(maxUnitSize, in, out);
+				}
+				if (strcmp(name, "pool.chunk_policy") == 0)
+				{
+					if (in && *in > DKMemoryChunkPolicyLowestAddress)
+						return EINVAL;
+					if (out)
+						*out = chunkPolicy.load(std::memory_order_relaxed);
+					if (in)
+						SetChunkPolicy(static_cast<DKMemoryChunkPolicy>(*in));
+					return 0;
+				}
+				if (strcmp(name, "pool.purge") == 0)
+				{
+					size_t purged = Purge();
+					if (out)
+						*out = purged;
+					return 0;
+				}
+
+				// read-only values
+				size_t value = 0;
+				if (strcmp(name, "pool.num_buckets") == 0)
+					value = NumAllocators;
+				else if (strcmp(name, "pool.max_bucket_size") == 0)
+					value = unitSizes[NumAllocators-1];
+				else if (strcmp(name, "backend.unit_size") == 0)
+					value = BackendAllocator::UnitSize;
+				else if (strcmp(name, "stats.pool_size") == 0)
+					value = Size();
+				else if (strcmp(name, "stats.allocated") == 0)
+				{
+					for (size_t i = 0; i < NumUnits; ++i)
+						value += allocators[i].NumberOfAllocatedUnits() * allocators[i].UnitStride();
+				}
+				else
+					return ENOENT;
+				if (in)
+					return EPERM;
+				if (out)
+					*out = value;
+				return 0;
+			}
+
 			size_t Purge(void)
 			{
-				size_t bytesPurged = 0;
+				for (int i = 0; i < NumUnits; ++i)
+				{
+					allocators[i].ConditionalPurge(0);
+				}
+				// empty slots are decommitted by explicit purge only.
+				return backend->Purge();
+			}
+
+			// advise pages of cold chunks, contents are preserved.
+			// (Linux only, pages can be reclaimed without being freed)
+			void AdviseCold(void)
+			{
+#if defined(MADV_PAGEOUT) || defined(MADV_COLD)
+				size_t pageSize = DKMemoryPageSize();
+				for (size_t i = 0; i < NumAllocators; ++i)
+				{
+					allocators[DKMemoryLifetimeCold * NumAllocators + i].EnumerateChunks([pageSize](void* chunk, size_t size)
+					{
+						size -= size % pageSize;
+						if (size > 0)
+						{
+#ifdef MADV_PAGEOUT
+							madvise(chunk, size, MADV_PAGEOUT);
+#else
+							madvise(chunk, size, MADV_COLD);
+#endif
+						}
+					});
+				}
+#endif
+			}
+
+			FORCEINLINE size_t Size(void) const
+			{
+				return backend->Size();
+			}
+
+			FORCEINLINE DKMemoryLocation Location(void) const
+			{
+				return DKMemoryLocationPool;
+			}
+
+			FORCEINLINE BackendAllocator* Backend(void)
+			{
+				return backend;
+			}
+
+			FORCEINLINE AllocatorUnit& GetAllocatorUnit(size_t index)
+			{
+				return allocators[index];
+			}
+			FORCEINLINE const AllocatorUnit& GetAllocatorUnit(size_t index) const
+			{
+				return allocators[index];
+			}
+
+		private:
+			FORCEINLINE bool DeallocAndPurge(AllocatorUnit* unit, void* p)
+			{
+				DKASSERT_MEM_DEBUG(unit);
+				DKASSERT_MEM_DEBUG(p);
+
+				size_t purged = 0;
+				if (unit->ConditionalDeallocAndPurge(p, bucketPurgeThreshold.load(std::memory_order_relaxed), &purged))
+				{
+					if (purged > 0)
+						PurgeBackend();
+					return true;
+				}
+				return false;
+			}
+			FORCEINLINE static int ControlValue(size_t& value, const size_t* in, size_t* out)
+			{
+				if (out)
+					*out = value;
+				if (in)
+					value = *in;
+				return 0;
+			}
+			FORCEINLINE static int ControlValue(std::atomic<size_t>& value, const size_t* in, size_t* out)
+			{
+				if (out)
+					*out = value.load(std::memory_order_relaxed);
+				if (in)
+					value.store(*in, std::memory_order_relaxed);
+				return 0;
+			}
+			// apply options of "name:value,name:value", invalid options are ignored.
+			void Configure(const char* conf)
+			{
+				char name[64];
+				while (*conf)
+				{
+					const char* end = conf + strcspn(conf, ",");
+					const char* sep = (const char*)memchr(conf, ':', end - conf);
+					int result = EINVAL;
+					if (sep && size_t(sep - conf) < sizeof(name))
+					{
+						memcpy(name, conf, sep - conf);
+						name[sep - conf] = 0;
+						char* valueEnd = NULL;
+						size_t value = (size_t)strtoull(sep + 1, &valueEnd, 0);
+						if (valueEnd == end && valueEnd != sep + 1)
+							result = Control(name, &value, NULL, true);
+					}
+					if (result != 0)
+						DKLog("DKMALLOC_CONF: invalid option \"%.*s\" ignored.\n", int(end - conf), conf);
+					conf = (*end) ? end + 1 : end;
+				}
+			}
+			FORCEINLINE AllocatorUnit* FindAllocatorForSize(size_t size)
+			{
+				return const_cast<AllocatorUnit*>(static_cast<const AllocatorPool*>(this)->FindAllocatorForSize(size));
+			}
+			FORCEINLINE const AllocatorUnit* FindAllocatorForSize(size_t size) const
+			{
+				return &allocators[FindAllocatorUnitForSize(unitSizes, NumAllocators, size)];
+			}
+			FORCEINLINE AllocatorUnit* FindAllocatorForSize(size_t size, DKMemoryLifetime lifetime)
+			{
+				DKASSERT_MEM_DEBUG(size_t(lifetime) < NumLifetimes);
+				return &allocators[size_t(lifetime) * NumAllocators + FindAllocatorUnitForSize(unitSizes, NumAllocators, size)];
+			}
+			FORCEINLINE DKMemoryLifetime LifetimeOfAllocator(const AllocatorUnit* unit) const
+			{
+				return static_cast<DKMemoryLifetime>((unit - allocators) / NumAllocators);
+			}
+			FORCEINLINE AllocatorUnit* FindAllocatorForAlignedSize(size_t size, size_t alignment)
+			{
+				if (size <= this->maxUnitSize)
+				{
+					// every chunk is page-aligned, a unit is aligned if unit size is multiple of alignment.
+					for (size_t i = FindAllocatorUnitForSize(unitSizes, NumAllocators, size); i < NumAllocators; ++i)
+					{
+						if ((unitSizes[i] % alignment) == 0)
+							return &allocators[i];
+					}
+				}
+				return NULL;
+			}
+			FORCEINLINE AllocatorUnit* FindAllocator(void* p)
+			{
+				BackendAllocator::Index index = backend->IndexForAddress(p);
+				if (index != BackendAllocator::IndexNotFound)
+				{
+					DKASSERT_MEM_DESC_DEBUG(index < NumUnits, "Address was allocated by ChunkAlloc!");
+					if (index < NumUnits)
+						return &allocators[index];
+				}
+				return NULL;
+			}
+
+			// rarely modified after initialized, never share cache line with buckets.
+			BackendAllocator* backend;
+			size_t maxUnitSize;				// large allocations are from VM (large.cutoff, init only)
+			std::atomic<size_t> bucketPurgeThreshold;	// free units kept by bucket (purge.bucket_threshold)
+			std::atomic<size_t> backendPurgeThreshold;	// empty slots kept by backend (purge.backend_threshold)
+			std::atomic<DKMemoryChunkPolicy> chunkPolicy;
+			size_t unitSizes[NumAllocators];
+			union { AllocatorUnit allocators[NumUnits]; };	// constructed by InitAllocatorUnits
+		};
+
+		AllocatorPool* GetAllocatorPool(void)
+		{
+			static DKAllocatorChain::Maintainer init;
+
+			static DKSpinLock lock;
+			static AllocatorPool* pool = NULL;
+			if (pool == NULL)
+			{
+				lock.Lock();
+				if (pool == NULL)
+				{
+					// It will be destroyed automatically.
+					// see DKAllocatorChain.cpp
+					pool = new AllocatorPool();
+				}
+				lock.Unlock();
+			}
+			return pool;
+		}
+
+		static BackendAllocator* SharedBackendAllocator(void)
+		{
+			return GetAllocatorPool()->Backend();
+		}
+
+		// used by DKMallocConst.h
+		DKGL_API void* PoolBucketInstance(size_t index)
+		{
+			return &GetAllocatorPool()->GetAllocatorUnit(index);
+		}
+		DKGL_API void* PoolBucketChunkAlloc(size_t index, size_t size, bool* zeroFilled)
+		{
+			return SharedBackendAllocator()->AllocWithIndex(BackendAllocator::Index(index), size, zeroFilled);
+		}
+		DKGL_API void PoolBucketChunkFree(size_t index, void* p)
+		{
+			BackendAllocator::Index i = SharedBackendAllocator()->Dealloc(p);
+			DKASSERT_MEM_DEBUG(i == index);
+			(void)i;
+			(void)index;
+		}
+		DKGL_API void PoolBucketChunkPurged(void)
+		{
+			GetAllocatorPool()->PurgeBackend();
+		}
+		DKGL_API void* PoolBucketMetadataAlloc(size_t s)
+		{
+			return MetadataAllocator::Alloc(s);
+		}
+		DKGL_API void* PoolBucketMetadataRealloc(void* p, size_t s)
+		{
+			return MetadataAllocator::Realloc(p, s);
+		}
+		DKGL_API void PoolBucketMetadataFree(void* p)
+		{
+			MetadataAllocator::Free(p);
+		}
+
+		// PrivateHeapBucketConfig : buckets of private heap. (no locking)
+		//   each heap has its own backend, chunks are released with the heap.
+		using PrivateHeapBackend = BackendAllocatorT<DKDummyLock>;
+		struct PrivateHeapChunkAllocator
+		{
+			PrivateHeapBackend* backend;
+			PrivateHeapBackend::Index index;
+
+			FORCEINLINE void* Alloc(size_t s)
+			{
+				DKASSERT_MEM_DEBUG(s <= PrivateHeapBackend::UnitSize);
+				return backend->AllocWithIndex(index, s);
+			}
+			FORCEINLINE void* Alloc(size_t s, bool* zeroFilled)
+			{
+				DKASSERT_MEM_DEBUG(s <= PrivateHeapBackend::UnitSize);
+				return backend->AllocWithIndex(index, s, zeroFilled);
+			}
+			FORCEINLINE void Free(void* p)
+			{
+				PrivateHeapBackend::Index i = backend->Dealloc(p);
+				DKASSERT_MEM_DEBUG(i == index);
+				(void)i;
+			}
+		};
+		struct PrivateHeapBucketConfig
+		{
+			using Lock = DKDummyLock;
+			using Backend = PrivateHeapBackend;
+			using BaseAllocator = MetadataAllocator;
+			using UnitAllocator = PrivateHeapChunkAllocator;
+			static UnitAllocator CreateUnitAllocator(Backend* backend, size_t index)
+			{
+				UnitAllocator allocator = { backend, PrivateHeapBackend::Index(index) };
+				return allocator;
+			}
+		};
+
+		// PrivateHeap : unsynchronized heap, with memory pool size classes.
+		//   large blocks (VM) are linked to be released with the heap.
+		struct PrivateHeap
+		{
+			enum { NumAllocators = NumAllocatorUnits };
+			using AllocatorUnit = Private::AllocatorUnit<PrivateHeapBucketConfig>;
+
+			PrivateHeap(void) : largeBlocks(NULL)
+			{
+				InitAllocatorUnits<PrivateHeapBucketConfig>(allocators, unitSizes, &backend);
+				maxUnitSize = unitSizes[NumAllocators - 1];
+			}
+			~PrivateHeap(void)
+			{
+				// release all memory at once.
 				for (int i = 0; i < NumAllocators; ++i)
 				{
-					bytesPurged += allocators[i].allocator->ConditionalPurge(0);
+					allocators[i].Clear();
+					allocators[i].~AllocatorUnit();
+				}
+				backend.Clear();
+				while (largeBlocks)
+				{
+					LargeBlock* block = largeBlocks;
+					largeBlocks = block->next;
+					DKMemoryVirtualFree(block);
+				}
+			}
+
+			void* Alloc(size_t s)
+			{
+				if (s > maxUnitSize)
+					return AllocLarge(s);
+
+				AllocatorUnit* unit = FindAllocatorForSize(s);
+				return unit->Alloc(s);
+			}
+
+			void* Realloc(void* p, size_t s)
+			{
+				if (p == NULL)
+					return Alloc(s);
+				if (s == 0)
+				{
+					Dealloc(p);
+					return NULL;
+				}
+
+				AllocatorUnit* unit = FindAllocator(p);
+				if (unit)
+				{
+					void* p2 = NULL;
+					if (s > maxUnitSize)
+					{
+						p2 = AllocLarge(s);
+					}
+					else
+					{
+						AllocatorUnit* unit2 = FindAllocatorForSize(s);
+						if (unit2 == unit)
+							return p;
+						p2 = unit2->Alloc(s);
+					}
+					if (p2)
+					{
+						memcpy(p2, p, Min(s, unit->UnitLength()));
+						DeallocAndPurge(unit, p);
+					}
+					return p2;
+				}
+				// large block
+				if (s > maxUnitSize)
+				{
+					LargeBlock* block = reinterpret_cast<LargeBlock*>(p) - 1;
+					Unlink(block);
+					LargeBlock* block2 = reinterpret_cast<LargeBlock*>(DKMemoryVirtualRealloc(block, s + sizeof(LargeBlock)));
+					if (block2 == NULL)
+					{
+						Link(block);
+						return NULL;
+					}
+					Link(block2);
+					return block2 + 1;
+				}
+				void* p2 = Alloc(s);
+				if (p2)
+				{
+					memcpy(p2, p, s);
+					FreeLarge(p);
 				}
-				if (bytesPurged > 0)
+				return p2;
+			}
+
+			void Dealloc(void* p)
+			{
+				if (p)
 				{
-					return backend->PurgeThreshold(0);
+					AllocatorUnit* unit = FindAllocator(p);
+					if (unit)
+						DeallocAndPurge(unit, p);
+					else
+						FreeLarge(p);
 				}
-				return 0;
 			}
 
-			FORCEINLINE size_t Size(void) const
+			size_t Size(void) const
 			{
-				return backend->Size();
+				size_t size = backend.Size();
+				for (LargeBlock* block = largeBlocks; block; block = block->next)
+					size += DKMemoryVirtualSize(block);
+				return size;
 			}
 
-			FORCEINLINE DKMemoryLocation Location(void) const
+		private:
+			struct alignas(16) LargeBlock
 			{
-				return DKMemoryLocationPool;
-			}
+				LargeBlock* prev;
+				LargeBlock* next;
+			};
 
-			FORCEINLINE BackendAllocator* Backend(void)
+			void* AllocLarge(size_t s)
 			{
-				return backend;
+				if (s + sizeof(LargeBlock) < s)
+					return NULL; // overflow
+				LargeBlock* block = reinterpret_cast<LargeBlock*>(DKMemoryVirtualAlloc(s + sizeof(LargeBlock)));
+				if (block == NULL)
+					return NULL;
+				Link(block);
+				return block + 1;
 			}
-
-			const AllocatorUnit& GetAllocatorUnit(size_t index) const
+			void FreeLarge(void* p)
 			{
-				return allocators[index];
+				LargeBlock* block = reinterpret_cast<LargeBlock*>(p) - 1;
+				Unlink(block);
+				DKMemoryVirtualFree(block);
 			}
-
-		private:
-			FORCEINLINE bool DeallocAndPurge(AllocatorUnit* unit, void* p)
+			FORCEINLINE void Link(LargeBlock* block)
+			{
+				block->prev = NULL;
+				block->next = largeBlocks;
+				if (largeBlocks)
+					largeBlocks->prev = block;
+				largeBlocks = block;
+			}
+			FORCEINLINE void Unlink(LargeBlock* block)
+			{
+				if (block->prev)
+					block->prev->next = block->next;
+				else
+					largeBlocks = block->next;
+				if (block->next)
+					block->next->prev = block->prev;
+			}
+			FORCEINLINE void DeallocAndPurge(AllocatorUnit* unit, void* p)
 			{
-				DKASSERT_MEM_DEBUG(unit);
-				DKASSERT_MEM_DEBUG(p);
-
-				//size_t threshold = BackendAllocator::UnitSize / (unit->unitSize);
-				size_t threshold = 0;
 				size_t purged = 0;
-				if (unit->allocator->ConditionalDeallocAndPurge(p, threshold, &purged))
+				if (unit->ConditionalDeallocAndPurge(p, DefaultBucketPurgeThreshold, &purged))
 				{
 					if (purged > 0)
-						backend->PurgeThreshold(16);
-					return true;
+						backend.PurgeThreshold(DefaultBackendPurgeThreshold);
+				}
+				else
+				{
+					DKASSERT_MEM_DEBUG(0);
 				}
-				return false;
 			}
 			FORCEINLINE AllocatorUnit* FindAllocatorForSize(size_t size)
 			{
-				size_t count = NumAllocators;
-				size_t start = 0;
-				size_t med;
-				while (count > 0)
-				{
-					med = count / 2;
-					if (size > allocators[start + med].unitSize)
-					{
-						start += med + 1;
-						count -= med + 1;
-					}
-					else
-					{
-						count = med;
-					}
-				}
-				return &allocators[start];
+				return &allocators[FindAllocatorUnitForSize(unitSizes, NumAllocators, size)];
 			}
 			FORCEINLINE AllocatorUnit* FindAllocator(void* p)
 			{
-				BackendAllocator::Index index = backend->IndexForAddress(p);
-				if (index != BackendAllocator::IndexNotFound)
+				PrivateHeapBackend::Index index = backend.IndexForAddress(p);
+				if (index != PrivateHeapBackend::IndexNotFound)
 					return &allocators[index];
 				return NULL;
 			}
 
-			BackendAllocator* backend;
-			AllocatorUnit allocators[NumAllocators];
+			PrivateHeapBackend backend;
 			size_t maxUnitSize;
+			size_t unitSizes[NumAllocators];
+			union { AllocatorUnit allocators[NumAllocators]; };	// constructed by InitAllocatorUnits
+			LargeBlock* largeBlocks;
 		};
 
-		AllocatorPool* GetAllocatorPool(void)
+		// FixedSizePoolChunkAllocator : allocates chunks for DKFixedSizePool.
+		//   chunks are allocated by AllocatorPool::ChunkAlloc if fits in
+		//   backend unit, otherwise allocated from system VM.
+		struct FixedSizePoolChunkAllocator
 		{
-			static DKAllocatorChain::Maintainer init;
+			enum { UnitSize = BackendAllocator::UnitSize };
 
-			static DKSpinLock lock;
-			static AllocatorPool* pool = NULL;
-			if (pool == NULL)
+			static void* Alloc(size_t s)
 			{
-				lock.Lock();
-				if (pool == NULL)
-				{
-					// It will be destroyed automatically.
-					// see DKAllocatorChain.cpp
-					pool = new AllocatorPool();
-				}
-				lock.Unlock();
+				if (s <= UnitSize)
+					return GetAllocatorPool()->ChunkAlloc();
+				return DKMemoryVirtualAlloc(s);
 			}
-			return pool;
-		}
-
-		BackendAllocator* BackendAllocator::Instance()
-		{
-			return GetAllocatorPool()->Backend();
-		}
+			static void Free(void* p)
+			{
+				if (SharedBackendAllocator()->IndexForAddress(p) != BackendAllocator::IndexNotFound)
+					GetAllocatorPool()->ChunkDealloc(p);
+				else
+					DKMemoryVirtualFree(p);
+			}
+		};
+		template <typename Lock>
+		using FixedSizePoolAllocator = DKFixedSizeAllocator<0, 1, 0xffff, Lock, MetadataAllocator, FixedSizePoolChunkAllocator>;
 
 		// VMSizeInfo : keep track VM-address, size pair.
 		struct VMSizeInfo
 		{
-			enum { SizeOffset = 64 };
+			enum { SizeOffset = 256 };	// initial capacity (4KB)
 			using Index = size_t;
 			enum : Index { IndexNotFound = ~Index(0) };
 
@@ -710,8 +1721,8 @@ namespace DKFoundation
 #endif
 				if (table.capacity <= table.count + 1)
 				{
-					size_t cap = table.capacity + SizeOffset;
-					Info* p = (Info*)DKMemoryHeapRealloc(table.data, cap * sizeof(Info));
+					size_t cap = Max(table.capacity * 2, size_t(SizeOffset));
+					Info* p = ResizeTable(table.data, table.count, table.capacity, cap);
 					if (p == NULL)		// out of memory.
 						return false;
 					table.capacity = cap;
@@ -756,7 +1767,7 @@ namespace DKFoundation
 				}
 				else
 				{
-					DKMemoryHeapFree(table.data);
+					ResizeTable(table.data, table.count, table.capacity, 0);
 					table.data = NULL;
 					table.capacity = 0;
 				}
@@ -815,9 +1826,134 @@ namespace DKFoundation
 				return IndexNotFound;
 			}
 
+			// table is stored in system pages directly, not in heap, because
+			// metadata of memory pool is allocated with VM. (see MetadataAllocator)
+			static Info* ResizeTable(Info* data, size_t count, size_t capacity, size_t newCapacity)
+			{
+				Info* newData = NULL;
+				if (newCapacity > 0)
+				{
+#ifdef _WIN32
+					newData = (Info*)::VirtualAlloc(0, newCapacity * sizeof(Info), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+					void* p = ::mmap(0, newCapacity * sizeof(Info), PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+					newData = (p == MAP_FAILED) ? NULL : (Info*)p;
+#endif
+					if (newData == NULL)
+						return NULL;
+					if (count > 0)
+						memcpy(newData, data, sizeof(Info) * Min(count, newCapacity));
+				}
+				if (data)
+				{
+#ifdef _WIN32
+					::VirtualFree(data, 0, MEM_RELEASE);
+#else
+					::munmap(data, capacity * sizeof(Info));
+#endif
+				}
+				return newData;
+			}
+
 			using ScopedLock = DKCriticalSection<DKSpinLock>;
 		};
 
+		static bool VirtualTryExpand(void* p, size_t s)
+		{
+			size_t pageSize = DKMemoryPageSize();
+			DKASSERT_MEM_DEBUG(pageSize != 0);
+			size_t alignedSize = s;
+			if (s % pageSize)
+				alignedSize += pageSize - (s % pageSize);
+
+			size_t sizeOrig = DKMemoryVirtualSize(p);
+			if (sizeOrig == 0)
+				return false;
+			if (alignedSize <= sizeOrig)
+				return true;
+#ifdef _WIN32
+			// region allocated with MEM_RESERVE can not be extended.
+			return false;
+#else
+			// mmap on next to the region, succeed only if kernel accepts the hint.
+			uintptr_t p2 = reinterpret_cast<uintptr_t>(p) + sizeOrig;
+			size_t len = alignedSize - sizeOrig;
+			void* p3 = ::mmap(reinterpret_cast<void*>(p2), len, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+			if (p3 == MAP_FAILED)
+				return false;
+			if (p2 != reinterpret_cast<uintptr_t>(p3))
+			{
+				if (::munmap(p3, len) != 0)
+				{
+					DKLog("munmap failed: %s\n", strerror(errno));
+				}
+				return false;
+			}
+			VMSizeInfo::Update(p, alignedSize, NULL);
+			return true;
+#endif
+		}
+
+		static void* VirtualAlignedAlloc(size_t s, size_t alignment)
+		{
+			size_t pageSize = DKMemoryPageSize();
+			DKASSERT_MEM_DEBUG(pageSize != 0);
+			DKASSERT_MEM_DEBUG((alignment % pageSize) == 0);
+
+			if (s == 0)
+				s = pageSize;
+			else if (s % pageSize)
+				s += pageSize - (s % pageSize);
+
+			size_t reserveSize = s + alignment - pageSize;
+			if (reserveSize < s)
+				return NULL; // overflow
+#ifdef _WIN32
+			for (int retry = 0; retry < 8; ++retry)
+			{
+				// reserve and release to find aligned address, other thread can take it.
+				void* p = ::VirtualAlloc(0, reserveSize, MEM_RESERVE, PAGE_NOACCESS);
+				if (p == NULL)
+					return NULL;
+				uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+				addr = (addr + alignment - 1) & ~(uintptr_t)(alignment - 1);
+				::VirtualFree(p, 0, MEM_RELEASE);
+				p = ::VirtualAlloc(reinterpret_cast<void*>(addr), s, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+				if (p)
+				{
+					DKASSERT_MEM_DEBUG(VMSizeInfo::Set(p, s));
+					return p;
+				}
+			}
+			return NULL;
+#else
+			void* p = ::mmap(0, reserveSize, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+			if (p == MAP_FAILED)
+			{
+				DKLog("mmap failed: %s\n", strerror(errno));
+				return NULL;
+			}
+			uintptr_t begin = reinterpret_cast<uintptr_t>(p);
+			uintptr_t addr = (begin + alignment - 1) & ~(uintptr_t)(alignment - 1);
+			uintptr_t end = begin + reserveSize;
+			// trim unaligned head and tail.
+			if (addr > begin && ::munmap(p, addr - begin) != 0)
+				DKLog("munmap failed: %s\n", strerror(errno));
+			if (end > addr + s && ::munmap(reinterpret_cast<void*>(addr + s), end - (addr + s)) != 0)
+				DKLog("munmap failed: %s\n", strerror(errno));
+
+			p = reinterpret_cast<void*>(addr);
+			if (!VMSizeInfo::Set(p, s))
+			{
+				DKLog("VMSizeInfo::Set failed.\n");
+				if (::munmap(p, s) != 0)
+					DKLog("munmap failed: %s\n", strerror(errno));
+				return NULL;
+			}
+			return p;
+#endif
+		}
+
 #ifdef _WIN32
 		static std::wstring Win32GetErrorString(DWORD dwError)
 		{
@@ -967,7 +2103,9 @@ namespace DKFoundation
 			{
 				uintptr_t p2 = reinterpret_cast<uintptr_t>(p) + alignedSize;
 				size_t len = sizeOrig - alignedSize;
+#if DKGL_MEMORY_DEBUG
 				DKLog("munmap(%lu, %lu)\n", p2, len);
+#endif
 				if (::munmap(reinterpret_cast<void*>(p2), len) != 0)
 				{
 					DKLog("munmap failed: %s\n", strerror(errno));
@@ -1000,7 +2138,9 @@ namespace DKFoundation
 					}
 					else
 					{
+#if DKGL_MEMORY_DEBUG
                         DKLog("mmap returns unwanted location(%p != %p). unmap and realloc\n", (const void*)p2, (const void*)p3);
+#endif
                         if (::munmap(p3, len) != 0)
 						{
 							DKLog("munmap failed: %s\n", strerror(errno));
@@ -1291,6 +2431,35 @@ namespace DKFoundation
 		return GetAllocatorPool()->Alloc(s);
 	}
 
+	DKGL_API void* DKMemoryPoolAlignedAlloc(size_t s, size_t alignment)
+	{
+		if (alignment & (alignment - 1))
+			return NULL;
+		return GetAllocatorPool()->AlignedAlloc(s, alignment);
+	}
+
+	DKGL_API void* DKMemoryPoolIsolatedAlloc(size_t s)
+	{
+		// unit of aligned bucket is multiple of alignment, a unit never
+		// shares cache line with neighbour units.
+		return GetAllocatorPool()->AlignedAlloc(s, DKGL_CACHE_LINE_SIZE);
+	}
+
+	DKGL_API void* DKMemoryPoolHintAlloc(size_t s, DKMemoryLifetime lifetime)
+	{
+		return GetAllocatorPool()->HintAlloc(s, lifetime);
+	}
+
+	DKGL_API void* DKMemoryPoolAllocNear(void* hint, size_t s)
+	{
+		return GetAllocatorPool()->AllocNear(hint, s);
+	}
+
+	DKGL_API void* DKMemoryPoolCalloc(size_t num, size_t size)
+	{
+		return GetAllocatorPool()->Calloc(num, size);
+	}
+
 	DKGL_API void* DKMemoryPoolRealloc(void* p, size_t s)
 	{
 		if (p && s)
@@ -1313,16 +2482,200 @@ namespace DKFoundation
 		GetAllocatorPool()->Dealloc(p);
 	}
 	
+	DKGL_API void DKMemoryPoolFreeSized(void* p, size_t s)
+	{
+		GetAllocatorPool()->DeallocSized(p, s);
+	}
+
+	DKGL_API void DKMemoryPoolAlignedFreeSized(void* p, size_t s, size_t alignment)
+	{
+		GetAllocatorPool()->AlignedDeallocSized(p, s, alignment);
+	}
+
 	DKGL_API size_t DKMemoryPoolPurge(void)
 	{
 		return GetAllocatorPool()->Purge();
 	}
 	
+	DKGL_API void DKMemoryPoolAdviseCold(void)
+	{
+		GetAllocatorPool()->AdviseCold();
+	}
+
 	DKGL_API size_t DKMemoryPoolSize(void)
 	{
 		return GetAllocatorPool()->Size();
 	}
 
+	DKGL_API size_t DKMemoryPoolUsableSize(void* p)
+	{
+		return GetAllocatorPool()->UsableSize(p);
+	}
+
+	DKGL_API size_t DKMemoryPoolGoodSize(size_t s)
+	{
+		return GetAllocatorPool()->GoodSize(s);
+	}
+
+	DKGL_API bool DKMemoryPoolTryExpand(void* p, size_t s)
+	{
+		return GetAllocatorPool()->TryExpand(p, s);
+	}
+
+	DKGL_API void* DKMemoryPoolChunkAlloc(void)
+	{
+		return GetAllocatorPool()->ChunkAlloc();
+	}
+
+	DKGL_API void DKMemoryPoolChunkFree(void* p)
+	{
+		GetAllocatorPool()->ChunkDealloc(p);
+	}
+
+	DKGL_API size_t DKMemoryPoolChunkSize(void)
+	{
+		return BackendAllocator::UnitSize;
+	}
+
+	DKGL_API size_t DKMemoryPoolNumberOfChunks(void)
+	{
+		return GetAllocatorPool()->Backend()->NumberOfUnitsWithIndex(AllocatorPool::ExternalChunkIndex);
+	}
+
+	struct DKPrivateHeap : public PrivateHeap
+	{
+	};
+
+	DKGL_API DKPrivateHeap* DKPrivateHeapCreate(void)
+	{
+		// allocated with VM pages, to align buckets with cache line.
+		void* p = DKMemoryVirtualAlloc(sizeof(DKPrivateHeap));
+		if (p)
+			return ::new (p) DKPrivateHeap();
+		return NULL;
+	}
+
+	DKGL_API void DKPrivateHeapDestroy(DKPrivateHeap* heap)
+	{
+		if (heap)
+		{
+			heap->~DKPrivateHeap();
+			DKMemoryVirtualFree(heap);
+		}
+	}
+
+	DKGL_API void* DKPrivateHeapAlloc(DKPrivateHeap* heap, size_t s)
+	{
+		return heap->Alloc(s);
+	}
+
+	DKGL_API void* DKPrivateHeapRealloc(DKPrivateHeap* heap, void* p, size_t s)
+	{
+		return heap->Realloc(p, s);
+	}
+
+	DKGL_API void DKPrivateHeapFree(DKPrivateHeap* heap, void* p)
+	{
+		heap->Dealloc(p);
+	}
+
+	DKGL_API size_t DKPrivateHeapSize(DKPrivateHeap* heap)
+	{
+		return heap->Size();
+	}
+
+	struct DKFixedSizePool
+	{
+		virtual ~DKFixedSizePool(void) noexcept(!DKGL_MEMORY_DEBUG) {}
+		virtual void* Alloc(void) = 0;
+		virtual void Dealloc(void*) = 0;
+		virtual void Reserve(size_t) = 0;
+		virtual size_t Purge(void) = 0;
+		virtual size_t Clear(void) = 0;
+		virtual void QueryStatus(DKFixedSizePoolStatus*) const = 0;
+	};
+
+	template <typename Lock> struct FixedSizePool : public DKFixedSizePool
+	{
+		// chunk can be larger than backend unit, for at least 8 units.
+		FixedSizePool(size_t unitSize, size_t alignment)
+			: allocator(unitSize, alignment, Max(size_t(FixedSizePoolChunkAllocator::UnitSize), (unitSize + alignment) * 8))
+		{
+		}
+
+		void* Alloc(void) override		{ return allocator.Alloc(allocator.UnitLength()); }
+		void Dealloc(void* p) override	{ allocator.Dealloc(p); }
+		void Reserve(size_t n) override	{ allocator.Reserve(n); }
+		size_t Purge(void) override		{ return allocator.Purge(); }
+		size_t Clear(void) override		{ return allocator.Clear(); }
+		void QueryStatus(DKFixedSizePoolStatus* status) const override
+		{
+			status->unitSize = allocator.UnitStride();
+			status->totalUnits = allocator.NumberOfUnits();
+			status->usedUnits = allocator.NumberOfAllocatedUnits();
+			status->size = allocator.Size();
+		}
+
+		FixedSizePoolAllocator<Lock> allocator;
+	};
+
+	DKGL_API DKFixedSizePool* DKFixedSizePoolCreate(size_t unitSize, size_t alignment, bool threadSafe)
+	{
+		if (unitSize == 0 || unitSize > (size_t(1) << 28))
+			return NULL;
+		if (alignment == 0 || (alignment & (alignment - 1)) || alignment > (1 << 15))
+			return NULL;
+
+		if (threadSafe)
+		{
+			void* p = MetadataAllocator::Alloc(sizeof(FixedSizePool<DKSpinLock>));
+			if (p)
+				return ::new (p) FixedSizePool<DKSpinLock>(unitSize, alignment);
+		}
+		else
+		{
+			void* p = MetadataAllocator::Alloc(sizeof(FixedSizePool<DKDummyLock>));
+			if (p)
+				return ::new (p) FixedSizePool<DKDummyLock>(unitSize, alignment);
+		}
+		return NULL;
+	}
+
+	DKGL_API void DKFixedSizePoolDestroy(DKFixedSizePool* pool)
+	{
+		if (pool)
+		{
+			pool->Clear();
+			pool->~DKFixedSizePool();
+			MetadataAllocator::Free(pool);
+		}
+	}
+
+	DKGL_API void* DKFixedSizePoolAlloc(DKFixedSizePool* pool)
+	{
+		return pool->Alloc();
+	}
+
+	DKGL_API void DKFixedSizePoolFree(DKFixedSizePool* pool, void* p)
+	{
+		pool->Dealloc(p);
+	}
+
+	DKGL_API void DKFixedSizePoolReserve(DKFixedSizePool* pool, size_t n)
+	{
+		pool->Reserve(n);
+	}
+
+	DKGL_API size_t DKFixedSizePoolPurge(DKFixedSizePool* pool)
+	{
+		return pool->Purge();
+	}
+
+	DKGL_API void DKFixedSizePoolQueryStatus(DKFixedSizePool* pool, DKFixedSizePoolStatus* status)
+	{
+		pool->QueryStatus(status);
+	}
+
 	DKGL_API size_t DKMemoryPoolNumberOfBuckets(void)
 	{
 		return AllocatorPool::NumAllocators;
@@ -1333,10 +2686,29 @@ namespace DKFoundation
 		size_t count = Min(numBuckets, (size_t)AllocatorPool::NumAllocators);
 		for (size_t i = 0; i < count; ++i)
 		{
-			const AllocatorUnit& unit = GetAllocatorPool()->GetAllocatorUnit(i);
-			status[i].chunkSize = unit.unitSize;
-			status[i].totalChunks = unit.allocator->NumberOfUnits();
-			status[i].usedChunks = unit.allocator->NumberOfAllocatedUnits();
+			const AllocatorPool::AllocatorUnit& unit = GetAllocatorPool()->GetAllocatorUnit(i);
+			status[i].chunkSize = unit.UnitLength();
+			status[i].totalChunks = unit.NumberOfUnits();
+			status[i].usedChunks = unit.NumberOfAllocatedUnits();
+			// buckets of other lifetimes with same unit size.
+			for (size_t k = 1; k < AllocatorPool::NumLifetimes; ++k)
+			{
+				const AllocatorPool::AllocatorUnit& unit2 = GetAllocatorPool()->GetAllocatorUnit(k * AllocatorPool::NumAllocators + i);
+				status[i].totalChunks += unit2.NumberOfUnits();
+				status[i].usedChunks += unit2.NumberOfAllocatedUnits();
+			}
 		}
 	}
+
+	DKGL_API void DKMemoryPoolSetChunkPolicy(DKMemoryChunkPolicy policy)
+	{
+		GetAllocatorPool()->SetChunkPolicy(policy);
+	}
+
+	DKGL_API int DKMemoryPoolControl(const char* name, const size_t* in, size_t* out)
+	{
+		if (name == NULL)
+			return EINVAL;
+		return GetAllocatorPool()->Control(name, in, out);
+	}
 }
\ No newline at end of file
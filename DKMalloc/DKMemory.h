@@ -79,17 +79,106 @@ namespace DKFoundation
 	/// allocate memory from memory pool
 	/// If the request exceeds 32KB, the system allocates using VM.
 	DKGL_API void* DKMemoryPoolAlloc(size_t);
+	/// allocate memory from memory pool with given alignment. (power of two)
+	/// use DKMemoryPoolFree to release.
+	DKGL_API void* DKMemoryPoolAlignedAlloc(size_t size, size_t alignment);
+	/// allocate memory from memory pool, which starts on a cache line and
+	/// never shares a cache line with other allocations. (for objects used
+	/// by different threads) use DKMemoryPoolFree to release.
+	DKGL_API void* DKMemoryPoolIsolatedAlloc(size_t size);
+	/// lifetime hint of memory pool allocation, each lifetime has its own
+	/// chunks in bucket, so that survivors do not pin chunks of temporaries.
+	enum DKMemoryLifetime
+	{
+		DKMemoryLifetimeDefault = 0,	///< same chunks as DKMemoryPoolAlloc
+		DKMemoryLifetimeShort,			///< temporaries, released soon
+		DKMemoryLifetimeLong,			///< kept for a long time (cache entries)
+		DKMemoryLifetimeCold,			///< rarely accessed, see DKMemoryPoolAdviseCold
+	};
+	/// allocate memory from chunks of lifetime, use DKMemoryPoolFree to release.
+	/// (DKMemoryPoolFreeSized can not be used)
+	DKGL_API void* DKMemoryPoolHintAlloc(size_t size, DKMemoryLifetime lifetime);
+	/// allocate memory close to hint (same chunk, same page if possible) if
+	/// hint was allocated from bucket of same size. use DKMemoryPoolFree to release.
+	DKGL_API void* DKMemoryPoolAllocNear(void* hint, size_t size);
+	/// allocate zero-filled memory for an array of num elements from memory pool.
+	/// returns NULL if num * size overflows.
+	DKGL_API void* DKMemoryPoolCalloc(size_t num, size_t size);
 	/// resize memory allocated by DKMemoryPoolAlloc
 	DKGL_API void* DKMemoryPoolRealloc(void*, size_t);
 	/// release memory allocated by DKMemoryPoolAlloc
 	DKGL_API void  DKMemoryPoolFree(void*);
-	/// purge unused memory pool chunks
+	/// release memory with the size requested to DKMemoryPoolAlloc (or Realloc)
+	/// bucket is selected by size without address lookup. (faster)
+	DKGL_API void  DKMemoryPoolFreeSized(void*, size_t);
+	/// release memory with the size, alignment requested to DKMemoryPoolAlignedAlloc
+	DKGL_API void  DKMemoryPoolAlignedFreeSized(void*, size_t size, size_t alignment);
+	/// purge unused memory pool chunks,
+	/// pages of empty backend units (256KB) are returned to system.
 	/// @note
 	///   If you run out of memory, call DKAllocatorChain::Cleanup
 	///   instead of calling DKMemoryPoolPurge, which purges memory pool only.
 	DKGL_API size_t DKMemoryPoolPurge(void);
+	/// advise system that chunks of DKMemoryLifetimeCold will not be accessed soon.
+	/// pages can be reclaimed, contents are preserved. (Linux only)
+	DKGL_API void DKMemoryPoolAdviseCold(void);
 	/// query memory pool size
 	DKGL_API size_t DKMemoryPoolSize(void);
+	/// query actual usable size of memory allocated by DKMemoryPoolAlloc.
+	/// (bucket unit size, or VM region size for large allocation)
+	DKGL_API size_t DKMemoryPoolUsableSize(void*);
+	/// query size that DKMemoryPoolAlloc will round up the given request to.
+	DKGL_API size_t DKMemoryPoolGoodSize(size_t);
+	/// resize memory allocated by DKMemoryPoolAlloc without moving.
+	/// returns false if memory could not be expanded in place. (nothing changed)
+	DKGL_API bool DKMemoryPoolTryExpand(void*, size_t);
+
+	/// allocate whole chunk of memory pool backend. (DKMemoryPoolChunkSize bytes)
+	/// chunk is page-aligned, use DKMemoryPoolChunkFree to release.
+	DKGL_API void* DKMemoryPoolChunkAlloc(void);
+	/// release chunk allocated by DKMemoryPoolChunkAlloc
+	DKGL_API void  DKMemoryPoolChunkFree(void*);
+	/// size of chunk allocated by DKMemoryPoolChunkAlloc (256KB)
+	DKGL_API size_t DKMemoryPoolChunkSize(void);
+	/// number of chunks allocated by DKMemoryPoolChunkAlloc. (DKArena, ...)
+	/// chunks are included in DKMemoryPoolSize.
+	DKGL_API size_t DKMemoryPoolNumberOfChunks(void);
+
+	/// private heap, has its own buckets and chunks without locking.
+	/// a heap must not be used by multiple threads at the same time.
+	struct DKPrivateHeap;
+	/// create private heap. (same size classes as memory pool)
+	DKGL_API DKPrivateHeap* DKPrivateHeapCreate(void);
+	/// destroy private heap, all memory allocated from the heap is released at once.
+	DKGL_API void  DKPrivateHeapDestroy(DKPrivateHeap*);
+	DKGL_API void* DKPrivateHeapAlloc(DKPrivateHeap*, size_t);
+	DKGL_API void* DKPrivateHeapRealloc(DKPrivateHeap*, void*, size_t);
+	DKGL_API void  DKPrivateHeapFree(DKPrivateHeap*, void*);
+	/// query private heap size, including reserved space.
+	DKGL_API size_t DKPrivateHeapSize(DKPrivateHeap*);
+
+	/// fixed-size pool, unit size is given at runtime.
+	/// uses same chunk and free-list engine as DKFixedSizeAllocator.
+	struct DKFixedSizePool;
+	struct DKFixedSizePoolStatus
+	{
+		size_t unitSize;		///< allocation unit size, including alignment padding
+		size_t totalUnits;		///< total units in the pool
+		size_t usedUnits;		///< allocated units
+		size_t size;			///< pool size in bytes, including reserved space
+	};
+	/// create fixed-size pool, alignment must be power of two. (up to 32KB)
+	/// pool without thread-safe must not be used by multiple threads at the same time.
+	DKGL_API DKFixedSizePool* DKFixedSizePoolCreate(size_t unitSize, size_t alignment, bool threadSafe);
+	/// destroy pool, all units allocated from the pool are released at once.
+	DKGL_API void  DKFixedSizePoolDestroy(DKFixedSizePool*);
+	DKGL_API void* DKFixedSizePoolAlloc(DKFixedSizePool*);
+	DKGL_API void  DKFixedSizePoolFree(DKFixedSizePool*, void*);
+	/// preallocate chunks for given number of units
+	DKGL_API void  DKFixedSizePoolReserve(DKFixedSizePool*, size_t numUnits);
+	/// release unoccupied chunks
+	DKGL_API size_t DKFixedSizePoolPurge(DKFixedSizePool*);
+	DKGL_API void  DKFixedSizePoolQueryStatus(DKFixedSizePool*, DKFixedSizePoolStatus*);
 
 	/**
 	 @brief
@@ -127,6 +216,47 @@ namespace DKFoundation
 	/// @see DKMemoryPoolBucketStatus
 	DKGL_API void DKMemoryPoolQueryAllocationStatus(DKMemoryPoolBucketStatus* status, size_t numBuckets);
 
+	/// chunk selection policy of fixed-size allocators. (pool buckets)
+	/// decides which chunk serves next allocations, steering allocations to
+	/// fewer chunks lets other chunks become empty and purgeable.
+	enum DKMemoryChunkPolicy
+	{
+		DKMemoryChunkPolicyDefault = 0,		///< switch to freed chunk if it is fuller
+		DKMemoryChunkPolicyMostOccupied,	///< allocate from the fullest non-full chunk (in eighths, lower address first)
+		DKMemoryChunkPolicyLowestAddress,	///< allocate from the lowest non-full chunk
+	};
+	/// set chunk selection policy of all memory pool buckets.
+	DKGL_API void DKMemoryPoolSetChunkPolicy(DKMemoryChunkPolicy);
+
+	/**
+	 @brief
+		Read and write tuning options of memory pool at runtime.
+		out receives current value (if not NULL), then in is applied (if not NULL).
+		Options can be given with environment variable DKMALLOC_CONF at pool
+		initialization, as "name:value,name:value".
+	 @code
+		size_t threshold = 64;
+		DKMemoryPoolControl("purge.bucket_threshold", &threshold, NULL);
+	 @endcode
+	 Options:
+		- purge.bucket_threshold : free units a bucket keeps before releasing empty chunks (0)
+		- purge.backend_threshold : empty backend units (256KB) kept before releasing to system (16)
+		- large.cutoff : allocations larger than this are from VM, up to 32768. (32768)
+		  rounded down to unit size of bucket, set by DKMALLOC_CONF only, read-only at runtime.
+		  DKMallocConst, DKPoolNew select bucket at compile time, ignore this and purge thresholds.
+		- pool.chunk_policy : DKMemoryChunkPolicy of buckets (0)
+		- pool.purge : purge memory pool, out receives purged bytes
+		- pool.num_buckets, pool.max_bucket_size, backend.unit_size : (read-only)
+		- stats.pool_size, stats.allocated : bytes of pool, bytes allocated from buckets (read-only)
+	 There are no decay time, cache size or stats toggle options:
+		empty chunks are released on free by purge thresholds (no time based decay),
+		buckets are shared by all threads (no thread caches),
+		and stats are computed when read (nothing to enable).
+	 @return
+		0 on success, ENOENT for unknown name, EPERM for read-only, EINVAL for invalid value.
+	 */
+	DKGL_API int DKMemoryPoolControl(const char* name, const size_t* in, size_t* out);
+
 	/// @brief track allocator location for debugging purpose
 	/// you can provide your own allocator.
 	/// @note
@@ -155,6 +285,7 @@ namespace DKFoundation
 	{
 		enum { Location = DKMemoryLocationVirtual };
 		static void* Alloc(size_t s)			{ return DKMemoryVirtualAlloc(s); }
+		static void* Alloc(size_t s, bool* z)	{ *z = true; return DKMemoryVirtualAlloc(s); } // VM pages are zero-filled
 		static void* Realloc(void* p, size_t s)	{ return DKMemoryVirtualRealloc(p, s); }
 		static void Free(void* p)				{ DKMemoryVirtualFree(p); }
 	};
@@ -0,0 +1,188 @@
+/*******************************************************************************
+ File: DKMemoryResource.h
+ Author: Hongtae Kim (tiff2766@gmail.com)
+
+ Copyright (c) 2015,2017 Hongtae Kim. All rights reserved.
+
+ NOTE: This is simplified 'Memory Allocator' part of DKGL.
+ Full version of DKGL: https://github.com/DKGL/DKGL
+
+ License: BSD-3
+*******************************************************************************/
+/*******************************************************************************
+
+ Copyright (c) 2015, Hongtae Kim.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of DKMalloc nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*******************************************************************************/
+
+#pragma once
+#include "DKDef.h"
+#include "DKMemory.h"
+#include "DKAllocator.h"
+#include "DKArena.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// DKMemoryResource.h
+// std::pmr::memory_resource implementations. (C++17 required)
+//
+//   std::pmr::vector<int> v(DKMemoryPoolResource());
+//
+//   DKMonotonicChunkResource resource;
+//   std::pmr::list<int> list(&resource);
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef DKGL_MEMORY_RESOURCE_ENABLED
+#if defined(__has_include)
+#if __has_include(<memory_resource>) && ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || __cplusplus >= 201703L)
+#define DKGL_MEMORY_RESOURCE_ENABLED 1
+#endif
+#endif
+#endif
+
+#if DKGL_MEMORY_RESOURCE_ENABLED
+#include <new>
+#include <memory_resource>
+
+namespace DKFoundation
+{
+	/// @brief memory_resource forwards to DKAllocator::DefaultAllocator(location)
+	/// memory pool resource releases memory with size and alignment.
+	/// (DKMemoryPoolAlignedFreeSized)
+	/// other locations align up to 16 bytes (page size for virtual memory),
+	/// larger alignments are over-allocated and aligned by hand.
+	class DKAllocatorResource : public std::pmr::memory_resource
+	{
+	public:
+		DKAllocatorResource(DKMemoryLocation loc = DKMemoryLocationDefault)
+			: allocator(DKAllocator::DefaultAllocator(loc))
+			, location(loc)
+		{
+		}
+
+		DKMemoryLocation Location(void) const { return location; }
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override
+		{
+			void* p = NULL;
+			if (location == DKMemoryLocationPool)
+				p = DKMemoryPoolAlignedAlloc(bytes, alignment);
+			else if (alignment <= NaturalAlignment())
+				p = allocator.Alloc(bytes);
+			else if (bytes <= size_t(-1) - alignment - sizeof(void*))
+			{
+				// keep original address in front of aligned block.
+				void* base = allocator.Alloc(bytes + alignment + sizeof(void*));
+				if (base)
+				{
+					uintptr_t addr = reinterpret_cast<uintptr_t>(base) + sizeof(void*);
+					addr = (addr + alignment - 1) & ~uintptr_t(alignment - 1);
+					p = reinterpret_cast<void*>(addr);
+					reinterpret_cast<void**>(p)[-1] = base;
+				}
+			}
+			if (p == NULL)
+				throw std::bad_alloc();
+			return p;
+		}
+		void do_deallocate(void* p, size_t bytes, size_t alignment) override
+		{
+			if (location == DKMemoryLocationPool)
+				DKMemoryPoolAlignedFreeSized(p, bytes, alignment);
+			else if (alignment <= NaturalAlignment())
+				allocator.Dealloc(p);
+			else
+				allocator.Dealloc(reinterpret_cast<void**>(p)[-1]);
+		}
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			if (this == &other)
+				return true;
+			const DKAllocatorResource* r = dynamic_cast<const DKAllocatorResource*>(&other);
+			return r && r->location == location;
+		}
+
+	private:
+		size_t NaturalAlignment(void) const
+		{
+			if (location == DKMemoryLocationVirtual)
+				return DKMemoryPageSize();
+			return 16;
+		}
+
+		DKAllocator& allocator;
+		DKMemoryLocation location;
+	};
+
+	/// shared memory_resource instance of memory pool.
+	inline std::pmr::memory_resource* DKMemoryPoolResource(void)
+	{
+		static DKAllocatorResource resource(DKMemoryLocationPool);
+		return &resource;
+	}
+
+	/// @brief monotonic memory_resource allocates from whole pool chunks.
+	/// memory is released when the resource is destroyed or release() called.
+	/// This class is not thread-safe.
+	/// @see DKArena
+	class DKMonotonicChunkResource : public std::pmr::memory_resource
+	{
+	public:
+		DKMonotonicChunkResource(void) {}
+
+		/// release all memory allocated from this resource.
+		void release(void)		{ arena.Release(); }
+
+		DKArena& Arena(void)	{ return arena; }
+
+		DKMonotonicChunkResource(const DKMonotonicChunkResource&) = delete;
+		DKMonotonicChunkResource& operator = (const DKMonotonicChunkResource&) = delete;
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override
+		{
+			void* p = arena.Alloc(bytes, alignment);
+			if (p == NULL)
+				throw std::bad_alloc();
+			return p;
+		}
+		void do_deallocate(void*, size_t, size_t) override
+		{
+			// memory is released by release()
+		}
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			return this == &other;
+		}
+
+	private:
+		DKArena arena;
+	};
+}
+#endif /* DKGL_MEMORY_RESOURCE_ENABLED */
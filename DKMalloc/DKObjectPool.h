@@ -0,0 +1,135 @@
+/*******************************************************************************
+ File: DKObjectPool.h
+ Author: Hongtae Kim (tiff2766@gmail.com)
+
+ Copyright (c) 2015,2017 Hongtae Kim. All rights reserved.
+
+ NOTE: This is simplified 'Memory Allocator' part of DKGL.
+ Full version of DKGL: https://github.com/DKGL/DKGL
+
+ License: BSD-3
+*******************************************************************************/
+/*******************************************************************************
+
+ Copyright (c) 2015, Hongtae Kim.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of DKMalloc nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*******************************************************************************/
+
+#pragma once
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "DKDef.h"
+#include "DKSpinLock.h"
+#include "DKFixedSizeAllocator.h"
+
+namespace DKFoundation
+{
+	/// @brief Object pool of type T, allocates objects from its own DKFixedSizeAllocator.
+	/// Clear() destroys all live objects and releases all chunks at once.
+	///
+	/// @tparam T          object type
+	/// @tparam Lock       locking class, use DKDummyLock for per-thread instance.
+	/// @tparam MaxUnits   max objects per chunk (default:1024)
+	///
+	/// @code
+	///   DKObjectPool<Node> pool;
+	///   Node* node = pool.New(arg1, arg2);
+	///   pool.Delete(node);
+	///   pool.Clear();	// destroy all nodes.
+	///
+	///   // per-thread instance (no locking)
+	///   static thread_local DKObjectPool<Node, DKDummyLock> localPool;
+	/// @endcode
+	template <typename T, typename Lock = DKSpinLock, unsigned int MaxUnits = 1024>
+	class DKObjectPool
+	{
+	public:
+		using Allocator = DKFixedSizeAllocator<sizeof(T), alignof(T), MaxUnits, Lock>;
+
+		DKObjectPool(void) {}
+		~DKObjectPool(void)
+		{
+			Clear();
+		}
+
+		/// allocate and construct object with arguments.
+		template <typename... Args> T* New(Args&&... args)
+		{
+			void* p = allocator.Alloc(sizeof(T));
+			if (p)
+			{
+				try
+				{
+					return ::new(p) T(std::forward<Args>(args)...);
+				}
+				catch (...)
+				{
+					allocator.Dealloc(p);
+					throw;
+				}
+			}
+			return NULL;
+		}
+		/// destroy and release object allocated by New.
+		void Delete(T* p)
+		{
+			if (p)
+			{
+				p->~T();
+				allocator.Dealloc(p);
+			}
+		}
+
+		/// destroy all objects and release memory.
+		/// if T is trivially destructible, objects are not enumerated.
+		size_t Clear(void)
+		{
+			if (!std::is_trivially_destructible<T>::value)
+			{
+				allocator.EnumerateAllocatedUnits([](void* p)
+				{
+					static_cast<T*>(p)->~T();
+				});
+			}
+			return allocator.Clear();
+		}
+
+		void Reserve(size_t n)						{ allocator.Reserve(n); }
+		size_t Purge(void)							{ return allocator.Purge(); }
+		size_t NumberOfObjects(void) const			{ return allocator.NumberOfAllocatedUnits(); }
+		size_t Size(void) const						{ return allocator.Size(); }
+
+		DKObjectPool(const DKObjectPool&) = delete;
+		DKObjectPool& operator = (const DKObjectPool&) = delete;
+
+	private:
+		Allocator allocator;
+	};
+}
@@ -0,0 +1,134 @@
+/*******************************************************************************
+ File: DKStdAllocator.h
+ Author: Hongtae Kim (tiff2766@gmail.com)
+
+ Copyright (c) 2015,2017 Hongtae Kim. All rights reserved.
+
+ NOTE: This is simplified 'Memory Allocator' part of DKGL.
+ Full version of DKGL: https://github.com/DKGL/DKGL
+
+ License: BSD-3
+*******************************************************************************/
+/*******************************************************************************
+
+ Copyright (c) 2015, Hongtae Kim.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of DKMalloc nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*******************************************************************************/
+
+#pragma once
+#include <new>
+#include "DKDef.h"
+#include "DKMemory.h"
+#include "DKFixedSizeAllocator.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// DKStdAllocator.h
+// allocators for C++ standard library containers.
+//
+//   std::vector<int, DKPoolStdAllocator<int>> v;
+//   std::map<int, int, std::less<int>, DKNodeAllocator<std::pair<const int, int>>> m;
+////////////////////////////////////////////////////////////////////////////////
+
+namespace DKFoundation
+{
+	/// @brief std::allocator compatible allocator, allocates from memory pool.
+	/// memory is released with size. (DKMemoryPoolFreeSized)
+	template <typename T> class DKPoolStdAllocator
+	{
+	public:
+		using value_type = T;
+		template <typename U> struct rebind { using other = DKPoolStdAllocator<U>; };
+
+		DKPoolStdAllocator(void) noexcept {}
+		template <typename U> DKPoolStdAllocator(const DKPoolStdAllocator<U>&) noexcept {}
+
+		T* allocate(size_t n)
+		{
+			if (n > size_t(-1) / sizeof(T))
+				throw std::bad_alloc();
+			void* p = (alignof(T) > 16) ?
+				DKMemoryPoolAlignedAlloc(n * sizeof(T), alignof(T)) :
+				DKMemoryPoolAlloc(n * sizeof(T));
+			if (p == NULL)
+				throw std::bad_alloc();
+			return static_cast<T*>(p);
+		}
+		void deallocate(T* p, size_t n) noexcept
+		{
+			if (alignof(T) > 16)
+				DKMemoryPoolAlignedFreeSized(p, n * sizeof(T), alignof(T));
+			else
+				DKMemoryPoolFreeSized(p, n * sizeof(T));
+		}
+	};
+	template <typename T, typename U>
+	FORCEINLINE bool operator == (const DKPoolStdAllocator<T>&, const DKPoolStdAllocator<U>&) noexcept { return true; }
+	template <typename T, typename U>
+	FORCEINLINE bool operator != (const DKPoolStdAllocator<T>&, const DKPoolStdAllocator<U>&) noexcept { return false; }
+
+	/// @brief std::allocator compatible allocator for node based containers.
+	/// (std::map, std::set, std::list, std::unordered_map, ...)
+	/// single object allocation (node) is allocated from shared
+	/// DKFixedSizeAllocator instance of each node type, array allocation
+	/// (hash table buckets) is allocated from memory pool.
+	template <typename T> class DKNodeAllocator
+	{
+	public:
+		using value_type = T;
+		template <typename U> struct rebind { using other = DKNodeAllocator<U>; };
+
+		using FixedSizeAllocator = DKFixedSizeAllocator<sizeof(T), alignof(T)>;
+
+		DKNodeAllocator(void) noexcept {}
+		template <typename U> DKNodeAllocator(const DKNodeAllocator<U>&) noexcept {}
+
+		T* allocate(size_t n)
+		{
+			void* p = NULL;
+			if (n == 1)
+				p = FixedSizeAllocator::AllocatorInstance().Alloc(sizeof(T));
+			else
+				p = DKPoolStdAllocator<T>().allocate(n);
+			if (p == NULL)
+				throw std::bad_alloc();
+			return static_cast<T*>(p);
+		}
+		void deallocate(T* p, size_t n) noexcept
+		{
+			if (n == 1)
+				FixedSizeAllocator::AllocatorInstance().Dealloc(p);
+			else
+				DKPoolStdAllocator<T>().deallocate(p, n);
+		}
+	};
+	template <typename T, typename U>
+	FORCEINLINE bool operator == (const DKNodeAllocator<T>&, const DKNodeAllocator<U>&) noexcept { return true; }
+	template <typename T, typename U>
+	FORCEINLINE bool operator != (const DKNodeAllocator<T>&, const DKNodeAllocator<U>&) noexcept { return false; }
+}
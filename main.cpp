@@ -19,6 +19,26 @@
 #define NUM_ALLOCATIONS_SMALL_BLOCKS 20000000	// num allocs for small blocks
 #define NUM_ALLOCATIONS_LARGE_BLOCKS 1000000	// num allocs for large blocks
 
+#define TEST_STL_CONTAINERS 0	// set 1 to test STL containers with DKPoolStdAllocator, DKNodeAllocator
+#define NUM_STL_CONTAINER_ITEMS 1000000	// num items for testing STL containers
+#define TEST_MEMORY_RESOURCES 0	// set 1 to test std::pmr memory resources (C++17 required)
+#define TEST_ARENA 0	// set 1 to test DKArena (allocate many, free all at once)
+#define TEST_FIXED_SIZE_POOL 0	// set 1 to test DKPool (fixed-size pool, C API)
+#define TEST_HANDLE_ALLOCATOR 0	// set 1 to test DKHandleAllocator (tree with 32-bit handles)
+#define TEST_COMPACTION 0	// set 1 to test DKCompactingHandleAllocator (incremental compaction)
+#define TEST_MALLOC_CONST 0	// set 1 to test DKMallocConst, DKFreeConst (compile-time bucket)
+#define TEST_MULTI_THREADS 0	// set 1 to test threads allocating from neighbouring buckets
+#define TEST_ISOLATED_ALLOC 0	// set 1 to test DKMallocIsolated with counters updated by threads
+#define TEST_CACHE_COLORING 0	// set 1 to walk headers of many objects (build with DKGL_MEMORY_CACHE_COLORING=1 to compare)
+#define TEST_CHUNK_POLICY 0	// set 1 to compare peak and steady resident size of churn with each DKMemSetChunkPolicy
+#define TEST_LIFETIME_HINT 0	// set 1 to compare purged size of mixed lifetimes with and without DKMallocHint
+#define TEST_ALLOC_NEAR 0	// set 1 to compare tree traversal with nodes allocated by DKMalloc and DKMallocNear
+#define TEST_CALLOC 0	// set 1 to check DKCalloc zero-fill of fresh and reused blocks
+#define TEST_METADATA_ALLOC 0	// set 1 to check pool metadata is not allocated from system heap (glibc)
+#define TEST_PRIVATE_HEAP 0	// set 1 to test DKHeapCreate/DKHeapDestroy (private heap without locks) against DKMalloc
+#define TEST_MALLOC_CTL 0	// set 1 to check DKMallocCtl and DKMALLOC_CONF parsing
+#define TEST_USABLE_SIZE 0	// set 1 to check DKMallocUsableSize, DKMallocGoodSize and DKTryExpand (in place, sized free)
+
 // before testing TBB, you need to download and install TBB
 // TBB official web page: https://www.threadingbuildingblocks.org
 
@@ -30,6 +50,91 @@
 #include "DKMalloc/DKMalloc.h"
 #include "DKTimer.h"
 
+#if TEST_STL_CONTAINERS
+#include <map>
+#include <list>
+#include <unordered_map>
+#include "DKMalloc/DKStdAllocator.h"
+#endif
+
+#if TEST_MEMORY_RESOURCES
+#include <map>
+#include <list>
+#include "DKMalloc/DKMemoryResource.h"
+#endif
+
+#if TEST_ARENA
+#include "DKMalloc/DKArena.h"
+#endif
+
+#if TEST_FIXED_SIZE_POOL
+#include <algorithm>
+#endif
+
+#if TEST_HANDLE_ALLOCATOR
+#include "DKMalloc/DKFixedSizeAllocator.h"
+#include "DKMalloc/DKHandleAllocator.h"
+#endif
+
+#if TEST_COMPACTION
+#include <algorithm>
+#include "DKMalloc/DKHandleAllocator.h"
+#endif
+
+#if TEST_MALLOC_CONST
+#include "DKMalloc/DKMallocConst.h"
+#endif
+
+#if TEST_MULTI_THREADS
+#include <algorithm>
+#include <thread>
+#include <vector>
+#endif
+
+#if TEST_CACHE_COLORING
+#include "DKMalloc/DKMallocConst.h"	// DKGL_MEMORY_CACHE_COLORING
+#endif
+
+#if TEST_ISOLATED_ALLOC
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <vector>
+#endif
+
+#if TEST_CHUNK_POLICY || TEST_LIFETIME_HINT
+#ifdef _WIN32
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <stdio.h>
+#include <unistd.h>
+#endif
+#endif
+
+#if TEST_LIFETIME_HINT
+#include <algorithm>
+#endif
+
+#if TEST_ALLOC_NEAR
+#include <algorithm>
+#endif
+
+#if TEST_CALLOC
+#include <string.h>
+#endif
+
+#if TEST_METADATA_ALLOC && defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#if TEST_PRIVATE_HEAP
+#include <algorithm>
+#include <string.h>
+#endif
+
 
 
 #ifdef _WIN32
@@ -111,6 +216,1170 @@ template <typename T, size_t Size> size_t NumArrayItems(T(&)[Size])
 	return Size;
 }
 
+#if TEST_STL_CONTAINERS
+template <template <typename> class Allocator> struct STLContainerTest
+{
+	using Map = std::map<int, int, std::less<int>, Allocator<std::pair<const int, int>>>;
+	using List = std::list<int, Allocator<int>>;
+	using UnorderedMap = std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, Allocator<std::pair<const int, int>>>;
+
+	static void Run(const char* desc, const int* keys, size_t numItems)
+	{
+		printf("\nTesting STL containers... (%s)\n", desc);
+		DKTimer timer;
+		double insertTime, eraseTime;
+
+		Map map;
+		timer.Reset();
+		for (size_t i = 0; i < numItems; ++i)
+			map[keys[i]] = int(i);
+		insertTime = timer.Elapsed();
+		timer.Reset();
+		for (size_t i = 0; i < numItems; ++i)
+			map.erase(keys[i]);
+		eraseTime = timer.Elapsed();
+		printf("    std::map insert: %f, erase: %f\n", insertTime, eraseTime);
+
+		List list;
+		timer.Reset();
+		for (size_t i = 0; i < numItems; ++i)
+			list.push_back(keys[i]);
+		insertTime = timer.Elapsed();
+		timer.Reset();
+		list.clear();
+		eraseTime = timer.Elapsed();
+		printf("    std::list insert: %f, erase: %f\n", insertTime, eraseTime);
+
+		UnorderedMap unorderedMap;
+		timer.Reset();
+		for (size_t i = 0; i < numItems; ++i)
+			unorderedMap[keys[i]] = int(i);
+		insertTime = timer.Elapsed();
+		timer.Reset();
+		for (size_t i = 0; i < numItems; ++i)
+			unorderedMap.erase(keys[i]);
+		eraseTime = timer.Elapsed();
+		printf("    std::unordered_map insert: %f, erase: %f\n", insertTime, eraseTime);
+	}
+};
+
+void TestSTLContainers(void)
+{
+	const size_t numItems = NUM_STL_CONTAINER_ITEMS;
+	int* keys = new int[numItems];
+	for (size_t i = 0; i < numItems; ++i)
+		keys[i] = int(DKRandom());
+
+	STLContainerTest<std::allocator>::Run("std::allocator", keys, numItems);
+	STLContainerTest<DKFoundation::DKPoolStdAllocator>::Run("DKPoolStdAllocator", keys, numItems);
+	STLContainerTest<DKFoundation::DKNodeAllocator>::Run("DKNodeAllocator", keys, numItems);
+
+	delete[] keys;
+}
+#endif
+
+#if TEST_MEMORY_RESOURCES
+void TestMemoryResources(void)
+{
+	const size_t numItems = NUM_STL_CONTAINER_ITEMS;
+	int* keys = new int[numItems];
+	for (size_t i = 0; i < numItems; ++i)
+		keys[i] = int(DKRandom());
+
+	auto run = [&](const char* desc, std::pmr::memory_resource* resource, void (*release)(std::pmr::memory_resource*))
+	{
+		printf("\nTesting memory resource... (%s)\n", desc);
+		DKTimer timer;
+		double insertTime, eraseTime;
+
+		timer.Reset();
+		{
+			std::pmr::map<int, int> map(resource);
+			std::pmr::list<int> list(resource);
+			for (size_t i = 0; i < numItems; ++i)
+			{
+				map[keys[i]] = int(i);
+				list.push_back(keys[i]);
+			}
+			insertTime = timer.Elapsed();
+			timer.Reset();
+		}
+		if (release)
+			release(resource);
+		eraseTime = timer.Elapsed();
+		printf("    std::pmr::map, std::pmr::list insert: %f, destroy: %f\n", insertTime, eraseTime);
+	};
+
+	std::pmr::monotonic_buffer_resource monotonicBuffer;
+	std::pmr::unsynchronized_pool_resource unsyncPool;
+	DKFoundation::DKMonotonicChunkResource monotonicChunk;
+
+	run("std::pmr::new_delete_resource", std::pmr::new_delete_resource(), nullptr);
+	run("std::pmr::monotonic_buffer_resource", &monotonicBuffer, [](std::pmr::memory_resource* r)
+	{
+		static_cast<std::pmr::monotonic_buffer_resource*>(r)->release();
+	});
+	run("std::pmr::unsynchronized_pool_resource", &unsyncPool, [](std::pmr::memory_resource* r)
+	{
+		static_cast<std::pmr::unsynchronized_pool_resource*>(r)->release();
+	});
+	run("DKMemoryPoolResource", DKFoundation::DKMemoryPoolResource(), nullptr);
+	run("DKMonotonicChunkResource", &monotonicChunk, [](std::pmr::memory_resource* r)
+	{
+		static_cast<DKFoundation::DKMonotonicChunkResource*>(r)->release();
+	});
+
+	delete[] keys;
+}
+#endif
+
+#if TEST_ARENA
+void TestArena(void)
+{
+	const size_t numRequests = 1000;
+	const size_t numAllocsPerRequest = 10000;
+	size_t* sizes = new size_t[numAllocsPerRequest];
+	void** ptrs = new void*[numAllocsPerRequest];
+	for (size_t i = 0; i < numAllocsPerRequest; ++i)
+		sizes[i] = (DKRandom() % 256) + 1;
+
+	printf("\nTesting arena... (%s requests, %s allocs per request)\n",
+		   FormatNumber(numRequests).c_str(), FormatNumber(numAllocsPerRequest).c_str());
+	DKTimer timer;
+
+	timer.Reset();
+	for (size_t r = 0; r < numRequests; ++r)
+	{
+		for (size_t i = 0; i < numAllocsPerRequest; ++i)
+			ptrs[i] = DKMalloc(sizes[i]);
+		for (size_t i = 0; i < numAllocsPerRequest; ++i)
+			DKFree(ptrs[i]);
+	}
+	printf("    DKMalloc, DKFree: %f\n", timer.Elapsed());
+
+	timer.Reset();
+	for (size_t r = 0; r < numRequests; ++r)
+	{
+		DKFoundation::DKArena arena;
+		for (size_t i = 0; i < numAllocsPerRequest; ++i)
+			ptrs[i] = arena.Alloc(sizes[i]);
+	}
+	printf("    DKArena (per request): %f\n", timer.Elapsed());
+
+	DKFoundation::DKArena arena;
+	timer.Reset();
+	for (size_t r = 0; r < numRequests; ++r)
+	{
+		for (size_t i = 0; i < numAllocsPerRequest; ++i)
+			ptrs[i] = arena.Alloc(sizes[i]);
+		arena.Reset();
+	}
+	printf("    DKArena (Reset): %f\n", timer.Elapsed());
+	printf("    DKArena size: %s bytes, %s chunks in memory pool.\n",
+		   FormatNumber(arena.Size()).c_str(), FormatNumber(DKFoundation::DKMemoryPoolNumberOfChunks()).c_str());
+	arena.Release();
+
+	delete[] sizes;
+	delete[] ptrs;
+}
+#endif
+
+#if TEST_FIXED_SIZE_POOL
+void TestFixedSizePool(void)
+{
+	const size_t unitSize = 40;
+	const size_t numRepeats = 20;
+	const size_t numAllocs = 1000000;
+	void** ptrs = new void*[numAllocs];
+	size_t* order = new size_t[numAllocs];
+	for (size_t i = 0; i < numAllocs; ++i)
+		order[i] = i;
+	for (size_t i = numAllocs - 1; i > 0; --i)	// shuffle free order
+		std::swap(order[i], order[DKRandom() % (i + 1)]);
+
+	printf("\nTesting fixed-size pool... (%s bytes, %s allocs x %s)\n",
+		   FormatNumber(unitSize).c_str(), FormatNumber(numAllocs).c_str(), FormatNumber(numRepeats).c_str());
+	DKTimer timer;
+
+	timer.Reset();
+	for (size_t r = 0; r < numRepeats; ++r)
+	{
+		for (size_t i = 0; i < numAllocs; ++i)
+			ptrs[i] = DKMalloc(unitSize);
+		for (size_t i = 0; i < numAllocs; ++i)
+			DKFree(ptrs[order[i]]);
+	}
+	printf("    DKMalloc, DKFree: %f\n", timer.Elapsed());
+
+	timer.Reset();
+	for (size_t r = 0; r < numRepeats; ++r)
+	{
+		for (size_t i = 0; i < numAllocs; ++i)
+			ptrs[i] = DKMalloc(unitSize);
+		for (size_t i = 0; i < numAllocs; ++i)
+			DKFreeSized(ptrs[order[i]], unitSize);
+	}
+	printf("    DKMalloc, DKFreeSized: %f\n", timer.Elapsed());
+
+	const unsigned int flags[] = { 0, DKPoolNoLock };
+	const char* desc[] = { "DKPoolAlloc, DKPoolFree", "DKPoolAlloc, DKPoolFree (DKPoolNoLock)" };
+	for (int k = 0; k < 2; ++k)
+	{
+		DKPool* pool = DKPoolCreate(unitSize, 8, flags[k]);
+		timer.Reset();
+		for (size_t r = 0; r < numRepeats; ++r)
+		{
+			for (size_t i = 0; i < numAllocs; ++i)
+				ptrs[i] = DKPoolAlloc(pool);
+			for (size_t i = 0; i < numAllocs; ++i)
+				DKPoolFree(pool, ptrs[order[i]]);
+		}
+		printf("    %s: %f\n", desc[k], timer.Elapsed());
+
+		DKPoolStatus status;
+		DKPoolStats(pool, &status);
+		printf("    DKPool unit: %s bytes, units: %s, size: %s bytes\n",
+			   FormatNumber(status.unitSize).c_str(), FormatNumber(status.totalUnits).c_str(), FormatNumber(status.size).c_str());
+		DKPoolDestroy(pool);
+	}
+
+	delete[] ptrs;
+	delete[] order;
+}
+#endif
+
+#if TEST_HANDLE_ALLOCATOR
+// binary search tree, nodes are linked with raw pointers (24 bytes per node)
+struct PointerTreeNode
+{
+	uint32_t key;
+	PointerTreeNode* left;
+	PointerTreeNode* right;
+};
+template <typename Allocator> struct PointerTree
+{
+	using Node = PointerTreeNode;
+	Allocator allocator;
+	Node* root = NULL;
+
+	void Insert(uint32_t key)
+	{
+		Node** link = &root;
+		while (*link)
+			link = (key < (*link)->key) ? &(*link)->left : &(*link)->right;
+		Node* node = (Node*)allocator.Alloc(sizeof(Node));
+		node->key = key;
+		node->left = node->right = NULL;
+		*link = node;
+	}
+	size_t Find(uint32_t key) const	// returns depth
+	{
+		size_t depth = 0;
+		for (const Node* node = root; node && node->key != key; ++depth)
+			node = (key < node->key) ? node->left : node->right;
+		return depth;
+	}
+};
+// binary search tree, nodes are linked with 32-bit handles (12 bytes per node)
+struct HandleTreeNode
+{
+	uint32_t key;
+	uint32_t left;
+	uint32_t right;
+};
+template <typename Allocator> struct HandleTree
+{
+	using Node = HandleTreeNode;
+	Allocator allocator;
+	uint32_t root = 0;
+
+	Node* Resolve(uint32_t h) const { return (Node*)allocator.Resolve(h); }
+	void Insert(uint32_t key)
+	{
+		uint32_t* link = &root;
+		while (*link)
+		{
+			Node* node = Resolve(*link);
+			link = (key < node->key) ? &node->left : &node->right;
+		}
+		uint32_t h = allocator.AllocHandle();
+		Node* node = Resolve(h);
+		node->key = key;
+		node->left = node->right = 0;
+		*link = h;
+	}
+	size_t Find(uint32_t key) const	// returns depth
+	{
+		size_t depth = 0;
+		for (uint32_t h = root; h; ++depth)
+		{
+			const Node* node = Resolve(h);
+			if (node->key == key)
+				break;
+			h = (key < node->key) ? node->left : node->right;
+		}
+		return depth;
+	}
+};
+
+template <typename Tree> void TestTree(const char* desc, const uint32_t* keys, size_t numKeys, size_t numLookups)
+{
+	DKTimer timer;
+	Tree* tree = new Tree();
+
+	timer.Reset();
+	for (size_t i = 0; i < numKeys; ++i)
+		tree->Insert(keys[i]);
+	double insertTime = timer.Elapsed();
+
+	size_t depth = 0;
+	timer.Reset();
+	for (size_t i = 0; i < numLookups; ++i)
+		depth += tree->Find(keys[(i * 7919) % numKeys]);
+	double findTime = timer.Elapsed();
+
+	printf("    insert: %f, find: %f (avg depth: %.1f, %s bytes) - [%s]\n",
+		   insertTime, findTime, double(depth) / double(numLookups),
+		   FormatNumber(tree->allocator.Size()).c_str(), desc);
+	tree->allocator.Clear();
+	delete tree;
+}
+
+void TestHandleAllocator(void)
+{
+	using namespace DKFoundation;
+	const size_t numKeys = 4000000;
+	const size_t numLookups = 4000000;
+	uint32_t* keys = new uint32_t[numKeys];
+	for (size_t i = 0; i < numKeys; ++i)
+		keys[i] = DKRandom();
+
+	printf("\nTesting handle allocator... (tree with %s nodes, %s lookups)\n",
+		   FormatNumber(numKeys).c_str(), FormatNumber(numLookups).c_str());
+
+	using PointerNode = PointerTreeNode;
+	using HandleNode = HandleTreeNode;
+	TestTree<PointerTree<DKFixedSizeAllocator<sizeof(PointerNode), alignof(PointerNode), 4096, DKDummyLock>>>(
+		"DKFixedSizeAllocator, pointer", keys, numKeys, numLookups);
+	TestTree<HandleTree<DKHandleAllocator<sizeof(HandleNode), alignof(HandleNode), 12, 0, DKDummyLock>>>(
+		"DKHandleAllocator, handle", keys, numKeys, numLookups);
+	TestTree<HandleTree<DKHandleAllocator<sizeof(HandleNode), alignof(HandleNode), 12, 8, DKDummyLock>>>(
+		"DKHandleAllocator, handle with generation", keys, numKeys, numLookups);
+
+	delete[] keys;
+}
+#endif
+
+#if TEST_COMPACTION
+void TestCompaction(void)
+{
+	const size_t numObjects = 2000000;
+	const size_t objectSize = 64;
+	const double timeBudget = 0.001;	// 1ms per step
+	uint32_t* handles = new uint32_t[numObjects];
+
+	printf("\nTesting compaction... (%s objects, %s bytes, 95%% released)\n",
+		   FormatNumber(numObjects).c_str(), FormatNumber(objectSize).c_str());
+
+	auto* allocator = new DKFoundation::DKCompactingHandleAllocator<objectSize, 8>();
+	for (size_t i = 0; i < numObjects; ++i)
+	{
+		handles[i] = allocator->AllocHandle();
+		memset(allocator->Resolve(handles[i]), 0, objectSize);
+	}
+	// release 95% of objects randomly, most chunks remain occupied sparsely.
+	size_t numLive = 0;
+	for (size_t i = 0; i < numObjects; ++i)
+	{
+		if (DKRandom() % 100 < 95)
+			allocator->FreeHandle(handles[i]);
+		else
+			handles[numLive++] = handles[i];
+	}
+	allocator->Purge();
+	printf("    before: %s bytes, %s units (%s allocated)\n",
+		   FormatNumber(allocator->Size()).c_str(),
+		   FormatNumber(allocator->NumberOfUnits()).c_str(),
+		   FormatNumber(allocator->NumberOfAllocatedUnits()).c_str());
+
+	DKTimer timer;
+	double maxStep = 0.0;
+	size_t numSteps = 0;
+	bool done = false;
+	timer.Reset();
+	while (!done)
+	{
+		DKTimer stepTimer;
+		stepTimer.Reset();
+		done = allocator->Compact(timeBudget);
+		maxStep = std::max(maxStep, stepTimer.Elapsed());
+		numSteps++;
+	}
+	printf("    Compact: %f (%s steps, longest step: %f)\n",
+		   timer.Elapsed(), FormatNumber(numSteps).c_str(), maxStep);
+	printf("    after: %s bytes, %s units (%s allocated)\n",
+		   FormatNumber(allocator->Size()).c_str(),
+		   FormatNumber(allocator->NumberOfUnits()).c_str(),
+		   FormatNumber(allocator->NumberOfAllocatedUnits()).c_str());
+
+	for (size_t i = 0; i < numLive; ++i)
+		allocator->FreeHandle(handles[i]);
+	delete allocator;
+	delete[] handles;
+}
+#endif
+
+#if TEST_MALLOC_CONST
+template <size_t N> void TestMallocConstSize(void** ptrs, size_t numAllocs, size_t numRepeats)
+{
+	DKTimer timer;
+	double allocTime = 0.0, freeTime = 0.0;
+	for (size_t r = 0; r < numRepeats; ++r)
+	{
+		timer.Reset();
+		for (size_t i = 0; i < numAllocs; ++i)
+			ptrs[i] = DKMalloc(N);
+		allocTime += timer.Elapsed();
+		timer.Reset();
+		for (size_t i = 0; i < numAllocs; ++i)
+			DKFree(ptrs[i]);
+		freeTime += timer.Elapsed();
+	}
+	printf("    alloc: %f, free: %f - [DKMalloc, DKFree (%d bytes)]\n", allocTime, freeTime, (int)N);
+
+	allocTime = freeTime = 0.0;
+	for (size_t r = 0; r < numRepeats; ++r)
+	{
+		timer.Reset();
+		for (size_t i = 0; i < numAllocs; ++i)
+			ptrs[i] = DKFoundation::DKMallocConst<N>();
+		allocTime += timer.Elapsed();
+		timer.Reset();
+		for (size_t i = 0; i < numAllocs; ++i)
+			DKFoundation::DKFreeConst<N>(ptrs[i]);
+		freeTime += timer.Elapsed();
+	}
+	printf("    alloc: %f, free: %f - [DKMallocConst, DKFreeConst (%d bytes)]\n", allocTime, freeTime, (int)N);
+}
+
+void TestMallocConst(void)
+{
+	const size_t numAllocs = 100000;
+	const size_t numRepeats = 100;
+	void** ptrs = new void*[numAllocs];
+
+	printf("\nTesting compile-time bucket... (%s allocs x %s)\n",
+		   FormatNumber(numAllocs).c_str(), FormatNumber(numRepeats).c_str());
+	TestMallocConstSize<24>(ptrs, numAllocs, numRepeats);
+	TestMallocConstSize<200>(ptrs, numAllocs, numRepeats);
+	TestMallocConstSize<3000>(ptrs, numAllocs, numRepeats);
+
+	delete[] ptrs;
+}
+#endif
+
+#if TEST_MULTI_THREADS
+void TestMultiThreads(void)
+{
+	// each thread allocates its own size class, buckets of neighbouring
+	// size classes are adjacent in memory. (false sharing if not padded)
+	const size_t numAllocs = 10000000;
+	const size_t batchSize = 8;
+	size_t maxThreads = std::max(std::thread::hardware_concurrency(), 1U);
+
+	printf("\nTesting threads with neighbouring buckets... (%s allocs per thread)\n",
+		   FormatNumber(numAllocs).c_str());
+	for (size_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+	{
+		DKTimer timer;
+		timer.Reset();
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < numThreads; ++t)
+		{
+			threads.emplace_back([=]()
+			{
+				size_t size = 16 * (t + 1);
+				void* ptrs[batchSize];
+				for (size_t i = 0; i < numAllocs; i += batchSize)
+				{
+					for (size_t k = 0; k < batchSize; ++k)
+						ptrs[k] = DKMalloc(size);
+					for (size_t k = 0; k < batchSize; ++k)
+						DKFree(ptrs[k]);
+				}
+			});
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+		printf("    threads: %d, elapsed: %f\n", (int)numThreads, timer.Elapsed());
+	}
+}
+#endif
+
+#if TEST_ISOLATED_ALLOC
+struct ConnectionCounter
+{
+	std::atomic<size_t> bytesSent;
+	std::atomic<size_t> bytesReceived;
+	size_t connectionId;
+	size_t flags;
+};
+
+// counters are allocated in turn for each thread, neighbour units belong to other threads.
+double TestCounters(void* (*alloc)(size_t), size_t numThreads, size_t numCounters, size_t numUpdates)
+{
+	std::vector<ConnectionCounter*> counters(numThreads * numCounters);
+	for (ConnectionCounter*& c : counters)
+	{
+		c = new(alloc(sizeof(ConnectionCounter))) ConnectionCounter();
+		c->bytesSent = 0;
+		c->bytesReceived = 0;
+	}
+
+	DKTimer timer;
+	timer.Reset();
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < numThreads; ++t)
+	{
+		threads.emplace_back([&counters, t, numThreads, numCounters, numUpdates]()
+		{
+			for (size_t i = 0; i < numUpdates; ++i)
+			{
+				ConnectionCounter* c = counters[(i % numCounters) * numThreads + t];
+				c->bytesSent.fetch_add(i, std::memory_order_relaxed);
+				c->bytesReceived.fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+	double elapsed = timer.Elapsed();
+
+	for (ConnectionCounter* c : counters)
+	{
+		c->~ConnectionCounter();
+		DKFree(c);
+	}
+	return elapsed;
+}
+
+void TestIsolatedAlloc(void)
+{
+	const size_t numCounters = 64;
+	const size_t numUpdates = 10000000;
+	size_t numThreads = std::max(std::thread::hardware_concurrency(), 2U);
+
+	printf("\nTesting counters shared across %d threads... (%d bytes counter, %s updates per thread)\n",
+		   (int)numThreads, (int)sizeof(ConnectionCounter), FormatNumber(numUpdates).c_str());
+	double t1 = TestCounters(DKMalloc, numThreads, numCounters, numUpdates);
+	printf("    elapsed: %f - [DKMalloc]\n", t1);
+	double t2 = TestCounters(DKMallocIsolated, numThreads, numCounters, numUpdates);
+	printf("    elapsed: %f - [DKMallocIsolated]\n", t2);
+}
+#endif
+
+#if TEST_CACHE_COLORING
+// read first cache line of each object repeatedly, objects are in many chunks (or VM regions).
+double TestWalkHeaders(size_t size, size_t numObjects, size_t numRepeats)
+{
+	void** objects = new void*[numObjects];
+	for (size_t i = 0; i < numObjects; ++i)
+	{
+		objects[i] = DKMalloc(size);
+		::memset(objects[i], (int)i, size);
+	}
+
+	DKTimer timer;
+	timer.Reset();
+	size_t sum = 0;
+	for (size_t r = 0; r < numRepeats; ++r)
+	{
+		for (size_t i = 0; i < numObjects; ++i)
+		{
+			const size_t* header = reinterpret_cast<const size_t*>(objects[i]);
+			for (size_t k = 0; k < 64 / sizeof(size_t); ++k)
+				sum += header[k];
+		}
+	}
+	double elapsed = timer.Elapsed();
+	printf("    elapsed: %f - [%d bytes x %s objects] (%x)\n",
+		   elapsed, (int)size, FormatNumber(numObjects).c_str(), (unsigned int)sum);
+
+	for (size_t i = 0; i < numObjects; ++i)
+		DKFree(objects[i]);
+	delete[] objects;
+	return elapsed;
+}
+
+void TestCacheColoring(void)
+{
+	printf("\nTesting headers of objects across chunks... (coloring: %s)\n",
+		   DKGL_MEMORY_CACHE_COLORING ? "enabled" : "disabled");
+	TestWalkHeaders(2720, 4096, 2000);	// pool chunks
+	TestWalkHeaders(60000, 1024, 2000);	// large blocks (VM)
+}
+#endif
+
+#if TEST_CHUNK_POLICY || TEST_LIFETIME_HINT
+// resident size of process (bytes)
+size_t ResidentSize(void)
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (::GetProcessMemoryInfo(::GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return pmc.WorkingSetSize;
+	return 0;
+#elif defined(__APPLE__)
+	mach_task_basic_info_data_t info;
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS)
+		return info.resident_size;
+	return 0;
+#else
+	long pages = 0, resident = 0;
+	FILE* fp = fopen("/proc/self/statm", "r");
+	if (fp)
+	{
+		if (fscanf(fp, "%ld %ld", &pages, &resident) != 2)
+			resident = 0;
+		fclose(fp);
+	}
+	return size_t(resident) * sysconf(_SC_PAGESIZE);
+#endif
+}
+#endif
+
+#if TEST_CHUNK_POLICY
+// grow to peak, shrink to 1/8 with churn, then churn at steady state.
+void TestChurn(int policy, const char* name, size_t peakObjects)
+{
+	const size_t steadyObjects = peakObjects / 8;
+	DKMemSetChunkPolicy(policy);
+
+	void** objects = new void*[peakObjects];
+	size_t numObjects = 0;
+	size_t baseSize = ResidentSize();
+
+	DKTimer timer;
+	timer.Reset();
+	while (numObjects < peakObjects)
+	{
+		size_t size = 16 + DKRandom() % 497;
+		objects[numObjects] = DKMalloc(size);
+		::memset(objects[numObjects], 0, size);
+		numObjects++;
+	}
+	size_t peakSize = ResidentSize();
+
+	for (size_t i = 0, n = peakObjects * 2; i < n; ++i)
+	{
+		size_t target = peakObjects - (peakObjects - steadyObjects) * i / n;
+		size_t index = DKRandom() % numObjects;
+		DKFree(objects[index]);
+		objects[index] = objects[--numObjects];
+		if (numObjects < target)
+		{
+			size_t size = 16 + DKRandom() % 497;
+			objects[numObjects] = DKMalloc(size);
+			::memset(objects[numObjects], 0, size);
+			numObjects++;
+		}
+	}
+	for (size_t i = 0, n = peakObjects * 2; i < n; ++i)
+	{
+		size_t index = DKRandom() % numObjects;
+		DKFree(objects[index]);
+		size_t size = 16 + DKRandom() % 497;
+		objects[index] = DKMalloc(size);
+		::memset(objects[index], 0, size);
+	}
+	size_t steadySize = ResidentSize();
+	DKMemPurge();
+	size_t purgedSize = ResidentSize();
+	double elapsed = timer.Elapsed();
+
+	printf("    %-15s peak: %6.1fMB, steady: %6.1fMB, purged: %6.1fMB, pool: %6.1fMB (elapsed: %f)\n",
+		   name,
+		   (double(peakSize) - double(baseSize)) / (1024 * 1024),
+		   (double(steadySize) - double(baseSize)) / (1024 * 1024),
+		   (double(purgedSize) - double(baseSize)) / (1024 * 1024),
+		   double(DKMemPoolSize()) / (1024 * 1024),
+		   elapsed);
+
+	for (size_t i = 0; i < numObjects; ++i)
+		DKFree(objects[i]);
+	delete[] objects;
+	DKMemPurge();
+	DKMemSetChunkPolicy(DKMemChunkPolicyDefault);
+}
+
+void TestChunkPolicy(void)
+{
+	printf("\nTesting chunk policies with churn (resident size from start)...\n");
+	TestChurn(DKMemChunkPolicyDefault, "Default", 1000000);
+	TestChurn(DKMemChunkPolicyMostOccupied, "MostOccupied", 1000000);
+	TestChurn(DKMemChunkPolicyLowestAddress, "LowestAddress", 1000000);
+}
+#endif
+
+#if TEST_LIFETIME_HINT
+// requests allocate bursts of temporaries, some of them are kept in cache.
+// cache entries left in chunks of temporaries prevent chunks from being purged.
+void TestLifetimes(int tempHint, int cacheHint, const char* name)
+{
+	const size_t numRequests = 200;
+	const size_t maxTemporaries = 100000;
+	const size_t cacheSize = 20000;
+
+	void** temporaries = new void*[maxTemporaries];
+	void** cache = new void*[cacheSize];
+	size_t numCached = 0;
+	size_t baseSize = ResidentSize();
+	size_t peakSize = 0;
+
+	DKTimer timer;
+	timer.Reset();
+	for (size_t r = 0; r < numRequests; ++r)
+	{
+		size_t numTemporaries = maxTemporaries / 4 + DKRandom() % (maxTemporaries * 3 / 4);
+		for (size_t i = 0; i < numTemporaries; ++i)
+		{
+			size_t size = 16 + DKRandom() % 497;
+			temporaries[i] = DKMallocHint(size, tempHint);
+			::memset(temporaries[i], 0, size);
+			if (i % 64 == 0)
+			{
+				size = 16 + DKRandom() % 497;
+				void* p = DKMallocHint(size, cacheHint);
+				::memset(p, 0, size);
+				if (numCached < cacheSize)
+				{
+					cache[numCached++] = p;
+				}
+				else
+				{
+					size_t index = DKRandom() % cacheSize;
+					DKFree(cache[index]);
+					cache[index] = p;
+				}
+			}
+		}
+		peakSize = std::max(peakSize, ResidentSize());
+		for (size_t i = 0; i < numTemporaries; ++i)
+			DKFree(temporaries[i]);
+	}
+	DKMemPurge();
+	size_t purgedSize = ResidentSize();
+	if (cacheHint == DKMallocHintCold)
+		DKMemAdviseCold();
+	size_t advisedSize = ResidentSize();
+	double elapsed = timer.Elapsed();
+
+	printf("    %-13s peak: %6.1fMB, purged: %6.1fMB, advised: %6.1fMB, pool: %6.1fMB (elapsed: %f)\n",
+		   name,
+		   (double(peakSize) - double(baseSize)) / (1024 * 1024),
+		   (double(purgedSize) - double(baseSize)) / (1024 * 1024),
+		   (double(advisedSize) - double(baseSize)) / (1024 * 1024),
+		   double(DKMemPoolSize()) / (1024 * 1024),
+		   elapsed);
+
+	for (size_t i = 0; i < numCached; ++i)
+		DKFree(cache[i]);
+	delete[] cache;
+	delete[] temporaries;
+	DKMemPurge();
+}
+
+void TestLifetimeHint(void)
+{
+	printf("\nTesting mixed lifetimes (resident size from start, cache entries alive after purge)...\n");
+	TestLifetimes(DKMallocHintNone, DKMallocHintNone, "No hint");
+	TestLifetimes(DKMallocHintShortLived, DKMallocHintLongLived, "Short/Long");
+	TestLifetimes(DKMallocHintShortLived, DKMallocHintCold, "Short/Cold");
+}
+#endif
+
+#if TEST_ALLOC_NEAR
+struct TreeNode
+{
+	TreeNode* left;
+	TreeNode* right;
+	size_t key;
+	char payload[40];
+};
+
+// build complete tree depth-first, children are allocated after parent.
+TreeNode* BuildTree(TreeNode* parent, size_t depth, bool near, size_t& key, size_t& samePage)
+{
+	if (depth == 0)
+		return NULL;
+	TreeNode* node = (TreeNode*)(near ? DKMallocNear(parent, sizeof(TreeNode)) : DKMalloc(sizeof(TreeNode)));
+	if (parent && (uintptr_t(parent) >> 12) == (uintptr_t(node) >> 12))
+		samePage++;
+	node->key = key++;
+	node->left = BuildTree(node, depth - 1, near, key, samePage);
+	node->right = BuildTree(node, depth - 1, near, key, samePage);
+	return node;
+}
+
+size_t TraverseTree(const TreeNode* node)
+{
+	size_t sum = 0;
+	while (node)
+	{
+		sum += node->key + TraverseTree(node->left);
+		node = node->right;
+	}
+	return sum;
+}
+
+void FreeTree(TreeNode* node)
+{
+	if (node)
+	{
+		FreeTree(node->left);
+		FreeTree(node->right);
+		DKFree(node);
+	}
+}
+
+// tree nodes on fragmented pool, allocated by DKMallocNear if near is true.
+void TestTreeTraversal(bool near, size_t depth, size_t numRepeats)
+{
+	size_t numNodes = (size_t(1) << depth) - 1;
+
+	// fragment bucket, free units are scattered over chunks.
+	size_t numFillers = numNodes * 2;
+	void** fillers = new void*[numFillers];
+	for (size_t i = 0; i < numFillers; ++i)
+		fillers[i] = DKMalloc(sizeof(TreeNode));
+	for (size_t i = numFillers - 1; i > 0; --i)
+		std::swap(fillers[i], fillers[DKRandom() % (i + 1)]);
+	for (size_t i = 0; i < numFillers / 2; ++i)
+		DKFree(fillers[i]);
+
+	size_t key = 0;
+	size_t samePage = 0;
+	TreeNode* root = BuildTree(NULL, depth, near, key, samePage);
+
+	DKTimer timer;
+	timer.Reset();
+	size_t sum = 0;
+	for (size_t r = 0; r < numRepeats; ++r)
+		sum += TraverseTree(root);
+	double elapsed = timer.Elapsed();
+	printf("    elapsed: %f - [%s] (same 4KB page as parent: %.1f%%, %x)\n",
+		   elapsed, near ? "DKMallocNear" : "DKMalloc",
+		   double(samePage) / double(numNodes - 1) * 100.0, (unsigned int)sum);
+
+	FreeTree(root);
+	for (size_t i = numFillers / 2; i < numFillers; ++i)
+		DKFree(fillers[i]);
+	delete[] fillers;
+	DKMemPurge();
+}
+
+void TestAllocNear(void)
+{
+	printf("\nTesting tree traversal, nodes on fragmented pool...\n");
+	TestTreeTraversal(false, 20, 20);
+	TestTreeTraversal(true, 20, 20);
+}
+#endif
+
+#if TEST_CALLOC
+// every block of DKCalloc must be zero, whether it is fresh or reused.
+void TestCalloc(void)
+{
+	const size_t sizes[] = { 16, 200, 3000, 20000, 100000, 1000000 };
+	const size_t numAllocs = 1000;
+	const size_t numRounds = 3;
+	void** ptrs = new void*[numAllocs];
+
+	printf("\nTesting DKCalloc zero-fill of fresh and reused blocks... (%s allocs x %d rounds)\n",
+		   FormatNumber(numAllocs).c_str(), (int)numRounds);
+	for (size_t size : sizes)
+	{
+		size_t numDirty = 0;
+		DKTimer timer;
+		timer.Reset();
+		for (size_t r = 0; r < numRounds; ++r)
+		{
+			for (size_t i = 0; i < numAllocs; ++i)
+			{
+				ptrs[i] = DKCalloc(1, size);
+				const unsigned char* p = static_cast<const unsigned char*>(ptrs[i]);
+				for (size_t k = 0; k < size; ++k)
+				{
+					if (p[k])
+					{
+						numDirty++;
+						break;
+					}
+				}
+			}
+			// dirty blocks before free, next round reuses them.
+			for (size_t i = 0; i < numAllocs; ++i)
+			{
+				::memset(ptrs[i], 0xff, size);
+				DKFree(ptrs[i]);
+			}
+		}
+		printf("    %9s bytes: %s (elapsed: %f)\n", FormatNumber(size).c_str(),
+			   numDirty ? "FAILED, non-zero blocks" : "ok", timer.Elapsed());
+	}
+	void* overflow = DKCalloc(size_t(-1) / 2 + 1, 2);
+	printf("    overflow num * size: %s\n", overflow ? "FAILED" : "ok");
+	DKFree(overflow);
+
+	delete[] ptrs;
+	DKMemPurge();
+}
+#endif
+
+#if TEST_METADATA_ALLOC
+// pool metadata (chunk tables, region tables, pools, heaps) is allocated
+// from VM pages, system heap must not grow while memory pool grows.
+void TestMetadataAlloc(void)
+{
+	printf("\nTesting metadata allocation... (system heap usage while memory pool grows)\n");
+#if defined(__GLIBC__) && defined(__GLIBC_PREREQ)
+	const size_t numAllocs = 200000;
+	const size_t numPools = 100;
+	void** ptrs = static_cast<void**>(DKMalloc(sizeof(void*) * numAllocs));
+	DKPool* pools[numPools];
+
+#if __GLIBC_PREREQ(2, 33)
+	size_t heapBefore = mallinfo2().uordblks;
+#else
+	size_t heapBefore = (unsigned int)mallinfo().uordblks;
+#endif
+	for (size_t i = 0; i < numAllocs; ++i)
+		ptrs[i] = DKMalloc(16 + DKRandom() % 2048);
+	for (size_t i = 0; i < numPools; ++i)
+	{
+		pools[i] = DKPoolCreate(8 + i * 8, 8, 0);
+		DKPoolAlloc(pools[i]);
+	}
+	DKHeap* heap = DKHeapCreate();
+	for (size_t i = 0; i < numAllocs / 10; ++i)
+		DKHeapAlloc(heap, 16 + DKRandom() % 2048);
+	size_t poolSize = DKMemPoolSize();
+#if __GLIBC_PREREQ(2, 33)
+	size_t heapAfter = mallinfo2().uordblks;
+#else
+	size_t heapAfter = (unsigned int)mallinfo().uordblks;
+#endif
+
+	DKHeapDestroy(heap);
+	for (size_t i = 0; i < numPools; ++i)
+		DKPoolDestroy(pools[i]);
+	for (size_t i = 0; i < numAllocs; ++i)
+		DKFree(ptrs[i]);
+	DKFree(ptrs);
+	DKMemPurge();
+
+	printf("    memory pool: %s bytes, system heap in use: %s -> %s bytes (%s)\n",
+		   FormatNumber(poolSize).c_str(), FormatNumber(heapBefore).c_str(), FormatNumber(heapAfter).c_str(),
+		   heapAfter > heapBefore ? "FAILED" : "ok");
+#else
+	printf("    skipped, system heap usage is read with glibc mallinfo.\n");
+#endif
+}
+#endif
+
+#if TEST_PRIVATE_HEAP
+// private heap: contents kept by DKHeapRealloc, all memory released by DKHeapDestroy.
+void TestPrivateHeap(void)
+{
+	const size_t numAllocs = 1000000;
+	const size_t numRepeats = 10;
+	void** ptrs = new void*[numAllocs];
+	size_t* sizes = new size_t[numAllocs];
+	for (size_t i = 0; i < numAllocs; ++i)
+		sizes[i] = 16 + DKRandom() % 256;
+
+	printf("\nTesting private heap... (%s allocs x %d)\n",
+		   FormatNumber(numAllocs).c_str(), (int)numRepeats);
+	DKTimer timer;
+
+	timer.Reset();
+	for (size_t r = 0; r < numRepeats; ++r)
+	{
+		for (size_t i = 0; i < numAllocs; ++i)
+			ptrs[i] = DKMalloc(sizes[i]);
+		for (size_t i = 0; i < numAllocs; ++i)
+			DKFree(ptrs[i]);
+	}
+	printf("    DKMalloc, DKFree: %f\n", timer.Elapsed());
+
+	timer.Reset();
+	for (size_t r = 0; r < numRepeats; ++r)
+	{
+		DKHeap* heap = DKHeapCreate();
+		for (size_t i = 0; i < numAllocs; ++i)
+			ptrs[i] = DKHeapAlloc(heap, sizes[i]);
+		for (size_t i = 0; i < numAllocs; ++i)
+			DKHeapFree(heap, ptrs[i]);
+		DKHeapDestroy(heap);
+	}
+	printf("    DKHeapAlloc, DKHeapFree: %f\n", timer.Elapsed());
+
+	timer.Reset();
+	for (size_t r = 0; r < numRepeats; ++r)
+	{
+		DKHeap* heap = DKHeapCreate();
+		for (size_t i = 0; i < numAllocs; ++i)
+			ptrs[i] = DKHeapAlloc(heap, sizes[i]);
+		DKHeapDestroy(heap);
+	}
+	printf("    DKHeapAlloc, DKHeapDestroy: %f\n", timer.Elapsed());
+
+	// realloc across small, large and back, contents must be kept.
+	const size_t reallocSizes[] = { 24, 3000, 100000, 40, 1 };
+	size_t numCorrupted = 0;
+	DKHeap* heap = DKHeapCreate();
+	size_t poolSize = DKMemPoolSize();
+	for (size_t i = 0; i < 1000; ++i)
+	{
+		unsigned char* p = static_cast<unsigned char*>(DKHeapAlloc(heap, 16));
+		::memset(p, int(i & 0xff), 16);
+		size_t valid = 16;
+		for (size_t s : reallocSizes)
+		{
+			p = static_cast<unsigned char*>(DKHeapRealloc(heap, p, s));
+			valid = std::min(valid, s);
+			for (size_t k = 0; k < valid; ++k)
+			{
+				if (p[k] != (i & 0xff))
+				{
+					numCorrupted++;
+					break;
+				}
+			}
+		}
+		if ((i % 2) == 0)
+			DKHeapFree(heap, p);
+	}
+	size_t heapSize = DKHeapSize(heap);
+	DKHeapDestroy(heap);
+	printf("    DKHeapRealloc: %s, heap size: %s bytes\n",
+		   numCorrupted ? "FAILED, contents not kept" : "ok", FormatNumber(heapSize).c_str());
+	printf("    DKHeapDestroy: memory pool %s bytes, %s\n", FormatNumber(DKMemPoolSize()).c_str(),
+		   DKMemPoolSize() == poolSize ? "unchanged (ok)" : "changed");
+
+	delete[] ptrs;
+	delete[] sizes;
+}
+#endif
+
+#if TEST_MALLOC_CTL
+// applied when memory pool is initialized, see main().
+const char* testMallocConf = "purge.bucket_threshold:64,purge.backend_threshold:8,large.cutoff:20000,pool.unknown:1";
+
+void SetTestMallocConf(void)
+{
+#ifdef _WIN32
+	_putenv_s("DKMALLOC_CONF", testMallocConf);
+#else
+	setenv("DKMALLOC_CONF", testMallocConf, 1);
+#endif
+}
+
+void TestMallocCtl(void)
+{
+	printf("\nTesting DKMallocCtl... (DKMALLOC_CONF=\"%s\")\n", testMallocConf);
+	size_t bucketThreshold = 0, backendThreshold = 0, cutoff = 0;
+	DKMallocCtl("purge.bucket_threshold", NULL, &bucketThreshold);
+	DKMallocCtl("purge.backend_threshold", NULL, &backendThreshold);
+	DKMallocCtl("large.cutoff", NULL, &cutoff);
+	// 20000 is not a unit size, cutoff is rounded down to unit size.
+	bool parsed = bucketThreshold == 64 && backendThreshold == 8 && cutoff <= 20000 && DKMallocGoodSize(cutoff) == cutoff;
+	printf("    DKMALLOC_CONF: %s (bucket_threshold: %d, backend_threshold: %d, large.cutoff: %d)\n",
+		   parsed ? "ok" : "FAILED", (int)bucketThreshold, (int)backendThreshold, (int)cutoff);
+
+	// blocks larger than cutoff are not allocated from buckets.
+	size_t allocated1 = 0, allocated2 = 0;
+	DKMallocCtl("stats.allocated", NULL, &allocated1);
+	void* p = DKMalloc(20000);
+	DKMallocCtl("stats.allocated", NULL, &allocated2);
+	DKFreeSized(p, 20000);
+	printf("    large.cutoff applied: %s\n", allocated1 == allocated2 ? "ok" : "FAILED");
+
+	// bucket blocks can not grow beyond cutoff, sized free must find the bucket.
+	size_t goodSize = DKMallocGoodSize(cutoff - 100);
+	p = DKMalloc(cutoff - 100);
+	bool bounded = goodSize <= cutoff && DKMallocUsableSize(p) == goodSize &&
+		DKTryExpand(p, goodSize) && !DKTryExpand(p, goodSize + 1);
+	DKFreeSized(p, goodSize);
+	printf("    large.cutoff bounds bucket blocks: %s (good size of %d: %d)\n",
+		   bounded ? "ok" : "FAILED", (int)(cutoff - 100), (int)goodSize);
+
+	struct { const char* name; size_t value; int result; } writes[] = {
+		{ "purge.bucket_threshold", 128, 0 },
+		{ "purge.bucket_threshold", 64, 0 },
+		{ "pool.chunk_policy", DKMemChunkPolicyLowestAddress, 0 },
+		{ "pool.chunk_policy", DKMemChunkPolicyDefault, 0 },
+		{ "pool.chunk_policy", 100, EINVAL },
+		{ "large.cutoff", 8192, EPERM },	// init only
+		{ "pool.num_buckets", 1, EPERM },
+		{ "pool.unknown", 1, ENOENT },
+	};
+	for (auto& w : writes)
+	{
+		int result = DKMallocCtl(w.name, &w.value, NULL);
+		printf("    %s = %d: %s\n", w.name, (int)w.value, result == w.result ? "ok" : "FAILED");
+	}
+	size_t purged = 0;
+	int result = DKMallocCtl("pool.purge", NULL, &purged);
+	printf("    pool.purge: %s (%s bytes)\n", result == 0 ? "ok" : "FAILED", FormatNumber(purged).c_str());
+}
+#endif
+
+#if TEST_USABLE_SIZE
+void TestUsableSize(void)
+{
+	printf("\nTesting DKMallocUsableSize, DKMallocGoodSize, DKTryExpand...\n");
+	// bucket sizes: block can grow up to its unit size only.
+	size_t bucketSizes[] = { 1, 16, 17, 100, 1000, 4097, 10000, 16384 };
+	for (size_t n : bucketSizes)
+	{
+		char* p = (char*)DKMalloc(n);
+		size_t goodSize = DKMallocGoodSize(n);
+		size_t usableSize = DKMallocUsableSize(p);
+		p[n - 1] = 'x';
+		bool expanded = DKTryExpand(p, goodSize) != 0;
+		bool crossed = DKTryExpand(p, goodSize + 1) != 0;
+		bool ok = goodSize >= n && usableSize == goodSize && expanded && !crossed &&
+			DKMallocUsableSize(p) == goodSize && p[n - 1] == 'x';
+		p[goodSize - 1] = 'y';
+		DKFreeSized(p, goodSize);	// sized free with expanded size.
+		printf("    bucket %d: %s (good size: %d)\n", (int)n, ok ? "ok" : "FAILED", (int)goodSize);
+	}
+	// VM sizes: page multiples, not colored. expanding over the region
+	// succeeds only if next pages are free.
+	size_t vmSizes[] = { size_t(1) << 20, size_t(3) << 20 };
+	for (size_t n : vmSizes)
+	{
+		char* p = (char*)DKMalloc(n);
+		size_t goodSize = DKMallocGoodSize(n);
+		size_t usableSize = DKMallocUsableSize(p);
+		p[n - 1] = 'x';
+		bool ok = goodSize == n && usableSize == goodSize && DKTryExpand(p, n - 1) && DKTryExpand(p, n);
+		size_t size = n;
+		bool grown = DKTryExpand(p, n * 2) != 0;
+		if (grown)
+		{
+			size = n * 2;
+			p[size - 1] = 'y';
+		}
+		ok = ok && DKMallocUsableSize(p) == size && p[n - 1] == 'x';
+		DKFreeSized(p, size);
+		printf("    VM %d: %s (%s)\n", (int)n, ok ? "ok" : "FAILED", grown ? "expanded in place" : "not expanded");
+	}
+}
+#endif
+
 #ifdef _WIN32
 int _tmain(int argc, _TCHAR* argv[])
 #else
@@ -135,6 +1404,10 @@ int main(int argc, const char * argv[])
 	scalable_allocation_mode(TBBMALLOC_USE_HUGE_PAGES, 1);
 #endif
 
+#if TEST_MALLOC_CTL
+	SetTestMallocConf();	// before memory pool is initialized.
+#endif
+
 	DKMemPurge();
 
 	enum { Alignment = 16 };
@@ -289,6 +1562,79 @@ int main(int argc, const char * argv[])
 			allocators[i].allocTime, allocators[i].deallocTime, allocators[i].desc);
 	}
 
+#if TEST_STL_CONTAINERS
+	TestSTLContainers();
+	printf("\n");
+#endif
+#if TEST_MEMORY_RESOURCES
+	TestMemoryResources();
+	printf("\n");
+#endif
+#if TEST_ARENA
+	TestArena();
+	printf("\n");
+#endif
+#if TEST_FIXED_SIZE_POOL
+	TestFixedSizePool();
+	printf("\n");
+#endif
+#if TEST_HANDLE_ALLOCATOR
+	TestHandleAllocator();
+	printf("\n");
+#endif
+#if TEST_COMPACTION
+	TestCompaction();
+	printf("\n");
+#endif
+#if TEST_MALLOC_CONST
+	TestMallocConst();
+	printf("\n");
+#endif
+#if TEST_MULTI_THREADS
+	TestMultiThreads();
+	printf("\n");
+#endif
+#if TEST_ISOLATED_ALLOC
+	TestIsolatedAlloc();
+	printf("\n");
+#endif
+#if TEST_CACHE_COLORING
+	TestCacheColoring();
+	printf("\n");
+#endif
+#if TEST_CHUNK_POLICY
+	TestChunkPolicy();
+	printf("\n");
+#endif
+#if TEST_LIFETIME_HINT
+	TestLifetimeHint();
+	printf("\n");
+#endif
+#if TEST_ALLOC_NEAR
+	TestAllocNear();
+	printf("\n");
+#endif
+#if TEST_CALLOC
+	TestCalloc();
+	printf("\n");
+#endif
+#if TEST_METADATA_ALLOC
+	TestMetadataAlloc();
+	printf("\n");
+#endif
+#if TEST_PRIVATE_HEAP
+	TestPrivateHeap();
+	printf("\n");
+#endif
+#if TEST_MALLOC_CTL
+	TestMallocCtl();
+	printf("\n");
+#endif
+#if TEST_USABLE_SIZE
+	TestUsableSize();
+	printf("\n");
+#endif
+
 	printf("DKMemoryPoolSize: %s bytes.\n", FormatNumber(DKMemPoolSize()).c_str());
 
 	//system("pause");